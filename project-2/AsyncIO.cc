@@ -0,0 +1,338 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/17/2026
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include "AsyncIO.h"
+
+#if defined(__linux__) && defined(__NR_io_uring_setup) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define HAVE_IO_URING 1
+#endif
+#endif
+
+RC AsyncIO::readAll(Request* reqs, int n)
+{
+  std::vector<Request*> pending(n);
+  std::vector<Request*> done(n);
+  int submitted = 0;
+  int completed = 0;
+  int rc;
+
+  for (int i = 0; i < n; i++) pending[i] = &reqs[i];
+
+  // keep as many reads in flight as the implementation accepts
+  while (completed < n) {
+    if (submitted < n) {
+      if ((rc = submit(&pending[submitted], n - submitted)) < 0) break;
+      submitted += rc;
+    }
+    if ((rc = reap(&done[0], n, 1)) < 0) break;
+    completed += rc;
+  }
+
+  // wait for the reads still in flight after an error
+  while (completed < submitted) {
+    if ((rc = reap(&done[0], n, 1)) < 0) return RC_FILE_READ_FAILED;
+    completed += rc;
+  }
+  if (completed < n) return RC_FILE_READ_FAILED;
+
+  // a short read past the end of the file is not an error
+  for (int i = 0; i < n; i++) {
+    if (reqs[i].result < 0) return RC_FILE_READ_FAILED;
+  }
+
+  return 0;
+}
+
+#ifdef HAVE_IO_URING
+
+/**
+ * io_uring, set up through the raw system calls so that liburing is
+ * not needed. requests are submitted as IORING_OP_READV, which is the
+ * oldest read operation the interface supports.
+ */
+class UringIO : public AsyncIO {
+ public:
+  UringIO() : ringFd(-1), sq(NULL), cq(NULL), sqes(NULL), inFlight(0) {}
+  ~UringIO();
+
+  RC  open(int depth);
+  int submit(Request* const* reqs, int n);
+  int reap(Request** done, int max, int min);
+  const char* name() const { return "io_uring"; }
+
+ private:
+  int enter(unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return (int)::syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, NULL, 0);
+  }
+
+  int    ringFd;
+  char*  sq;         // the submission ring
+  char*  cq;         // the completion ring; may be the same mapping as sq
+  struct io_uring_sqe* sqes;
+  size_t sqSize, cqSize;
+  unsigned sqEntries, cqEntries;
+  struct io_uring_params params;
+  int    inFlight;   // # of submitted requests not reaped yet
+
+  unsigned* sqTail() const  { return (unsigned*)(sq + params.sq_off.tail); }
+  unsigned  sqMask() const  { return *(unsigned*)(sq + params.sq_off.ring_mask); }
+  unsigned* sqArray() const { return (unsigned*)(sq + params.sq_off.array); }
+  unsigned* cqHead() const  { return (unsigned*)(cq + params.cq_off.head); }
+  unsigned* cqTail() const  { return (unsigned*)(cq + params.cq_off.tail); }
+  unsigned  cqMask() const  { return *(unsigned*)(cq + params.cq_off.ring_mask); }
+  struct io_uring_cqe* cqes() const { return (struct io_uring_cqe*)(cq + params.cq_off.cqes); }
+};
+
+RC UringIO::open(int depth)
+{
+  memset(&params, 0, sizeof(params));
+  ringFd = (int)::syscall(__NR_io_uring_setup, depth, &params);
+  if (ringFd < 0) return RC_FILE_OPEN_FAILED;
+
+  sqEntries = params.sq_entries;
+  cqEntries = params.cq_entries;
+  sqSize = params.sq_off.array + sqEntries * sizeof(unsigned);
+  cqSize = params.cq_off.cqes + cqEntries * sizeof(struct io_uring_cqe);
+
+  // newer kernels map both rings with one mmap()
+  bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single) sqSize = cqSize = (sqSize > cqSize) ? sqSize : cqSize;
+
+  void* addr = ::mmap(NULL, sqSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+  if (addr == MAP_FAILED) return RC_OUT_OF_MEMORY;
+  sq = (char*)addr;
+
+  if (single) {
+    cq = sq;
+  } else {
+    addr = ::mmap(NULL, cqSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+    if (addr == MAP_FAILED) return RC_OUT_OF_MEMORY;
+    cq = (char*)addr;
+  }
+
+  addr = ::mmap(NULL, sqEntries * sizeof(struct io_uring_sqe), PROT_READ|PROT_WRITE,
+                MAP_SHARED|MAP_POPULATE, ringFd, IORING_OFF_SQES);
+  if (addr == MAP_FAILED) return RC_OUT_OF_MEMORY;
+  sqes = (struct io_uring_sqe*)addr;
+
+  return 0;
+}
+
+UringIO::~UringIO()
+{
+  Request* done[64];
+
+  // the kernel writes into the buffers of reads in flight
+  while (inFlight > 0 && reap(done, 64, 1) > 0) { }
+
+  if (sqes != NULL) ::munmap(sqes, sqEntries * sizeof(struct io_uring_sqe));
+  if (cq != NULL && cq != sq) ::munmap(cq, cqSize);
+  if (sq != NULL) ::munmap(sq, sqSize);
+  if (ringFd >= 0) ::close(ringFd);
+}
+
+int UringIO::submit(Request* const* reqs, int n)
+{
+  // never have more reads in flight than the completion ring can hold
+  int room = (int)((sqEntries < cqEntries ? sqEntries : cqEntries)) - inFlight;
+  if (n > room) n = room;
+  if (n <= 0) return 0;
+
+  // we are the only producer: the tail is ours, the kernel moves the head
+  unsigned tail = *sqTail();
+  unsigned mask = sqMask();
+
+  for (int i = 0; i < n; i++) {
+    Request* req = reqs[i];
+    unsigned index = tail & mask;
+    struct io_uring_sqe* sqe = &sqes[index];
+
+    req->iov.iov_base = req->buffer;
+    req->iov.iov_len = req->length;
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = req->fd;
+    sqe->off = req->offset;
+    sqe->addr = (unsigned long)&req->iov;
+    sqe->len = 1;
+    sqe->user_data = (unsigned long)req;
+
+    sqArray()[index] = index;
+    tail++;
+  }
+  __atomic_store_n(sqTail(), tail, __ATOMIC_RELEASE);
+
+  int submitted = enter(n, 0, 0);
+  if (submitted < 0) return RC_FILE_READ_FAILED;
+
+  inFlight += submitted;
+  return submitted;
+}
+
+int UringIO::reap(Request** done, int max, int min)
+{
+  int count = 0;
+
+  if (min > inFlight) min = inFlight;
+
+  for (;;) {
+    unsigned head = *cqHead();
+    unsigned tail = __atomic_load_n(cqTail(), __ATOMIC_ACQUIRE);
+    unsigned mask = cqMask();
+
+    while (head != tail && count < max) {
+      struct io_uring_cqe* cqe = &cqes()[head & mask];
+      Request* req = (Request*)(unsigned long)cqe->user_data;
+      req->result = cqe->res;
+      done[count++] = req;
+      head++;
+    }
+    __atomic_store_n(cqHead(), head, __ATOMIC_RELEASE);
+
+    if (count >= min || count >= max) break;
+
+    // sleep in the kernel until enough reads completed
+    if (enter(0, min - count, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+      inFlight -= count;
+      return RC_FILE_READ_FAILED;
+    }
+  }
+
+  inFlight -= count;
+  return count;
+}
+
+#endif // HAVE_IO_URING
+
+/**
+ * a fixed number of threads, each running one blocking pread() at a time.
+ */
+class ThreadPoolIO : public AsyncIO {
+ public:
+  ThreadPoolIO(int threads);
+  ~ThreadPoolIO();
+
+  int submit(Request* const* reqs, int n);
+  int reap(Request** done, int max, int min);
+  const char* name() const { return "threads"; }
+
+ private:
+  void work();
+
+  std::vector<std::thread> workers;
+  std::deque<Request*>     queued;    // submitted, not started
+  std::deque<Request*>     completed; // finished, not reaped
+  int                      inFlight;  // submitted, not reaped
+  bool                     stopping;
+  std::mutex               latch;     // protects the members above
+  std::condition_variable  hasWork;
+  std::condition_variable  hasDone;
+};
+
+ThreadPoolIO::ThreadPoolIO(int threads)
+: inFlight(0), stopping(false)
+{
+  for (int i = 0; i < threads; i++) {
+    workers.push_back(std::thread(&ThreadPoolIO::work, this));
+  }
+}
+
+ThreadPoolIO::~ThreadPoolIO()
+{
+  {
+    std::lock_guard<std::mutex> guard(latch);
+    stopping = true;
+  }
+  hasWork.notify_all();
+  for (unsigned i = 0; i < workers.size(); i++) workers[i].join();
+}
+
+void ThreadPoolIO::work()
+{
+  std::unique_lock<std::mutex> guard(latch);
+
+  for (;;) {
+    while (queued.empty() && !stopping) hasWork.wait(guard);
+    if (queued.empty()) return;
+
+    Request* req = queued.front();
+    queued.pop_front();
+
+    // read without holding the latch
+    guard.unlock();
+    ssize_t n = ::pread(req->fd, req->buffer, req->length, req->offset);
+    req->result = (n < 0) ? -errno : n;
+    guard.lock();
+
+    completed.push_back(req);
+    hasDone.notify_all();
+  }
+}
+
+int ThreadPoolIO::submit(Request* const* reqs, int n)
+{
+  {
+    std::lock_guard<std::mutex> guard(latch);
+    for (int i = 0; i < n; i++) queued.push_back(reqs[i]);
+    inFlight += n;
+  }
+  hasWork.notify_all();
+
+  return n;
+}
+
+int ThreadPoolIO::reap(Request** done, int max, int min)
+{
+  std::unique_lock<std::mutex> guard(latch);
+  int count = 0;
+
+  if (min > inFlight) min = inFlight;
+  while ((int)completed.size() < min) hasDone.wait(guard);
+
+  while (!completed.empty() && count < max) {
+    done[count++] = completed.front();
+    completed.pop_front();
+  }
+  inFlight -= count;
+
+  return count;
+}
+
+AsyncIO* AsyncIO::createUring(int depth)
+{
+#ifdef HAVE_IO_URING
+  UringIO* io = new UringIO;
+  if (io->open(depth) == 0) return io;
+  delete io;
+#endif
+  return NULL;
+}
+
+AsyncIO* AsyncIO::createThreadPool(int threads)
+{
+  return new ThreadPoolIO(threads);
+}
+
+AsyncIO* AsyncIO::create(int depth)
+{
+  // io_uring may be missing from the kernel or blocked by a seccomp policy
+  AsyncIO* io = createUring(depth);
+  return (io != NULL) ? io : createThreadPool(depth < 8 ? depth : 8);
+}
@@ -0,0 +1,91 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/17/2026
+ */
+
+#ifndef ASYNCIO_H
+#define ASYNCIO_H
+
+#include <sys/types.h>
+#include <sys/uio.h>
+#include "Bruinbase.h"
+
+/**
+ * Reads file blocks asynchronously: a batch of reads is submitted at once
+ * and their completions are reaped later, so that many reads can be in
+ * flight on the device at the same time.
+ *
+ * create() picks io_uring when the kernel offers it and falls back to a
+ * small pool of threads issuing pread() otherwise. An AsyncIO object must
+ * be used by one thread at a time.
+ */
+class AsyncIO {
+ public:
+  /**
+   * a single read.
+   */
+  struct Request {
+    int     fd;      // the file to read from
+    off_t   offset;  // where to start reading
+    char*   buffer;  // where to put the data
+    size_t  length;  // # of bytes to read
+    ssize_t result;  // set on completion: # bytes read, or -errno
+
+    struct iovec iov; // used by the implementation
+  };
+
+  virtual ~AsyncIO() {}
+
+  /**
+   * start a batch of reads. the requests must stay alive until reaped.
+   * fewer than n requests are accepted if too many reads are in flight.
+   * @param reqs[IN] the reads to start
+   * @param n[IN] the number of reads
+   * @return the # of requests accepted, or an error code
+   */
+  virtual int submit(Request* const* reqs, int n) = 0;
+
+  /**
+   * collect completed reads, waiting until at least min of them completed.
+   * @param done[OUT] the completed requests, in no particular order
+   * @param max[IN] the capacity of done
+   * @param min[IN] the # of completions to wait for
+   * @return the # of requests stored in done, or an error code
+   */
+  virtual int reap(Request** done, int max, int min) = 0;
+
+  /**
+   * @return the short name of the implementation ("io_uring", "threads")
+   */
+  virtual const char* name() const = 0;
+
+  /**
+   * submit n reads and wait until all of them completed.
+   * @param reqs[IN/OUT] the reads; their result fields are set
+   * @param n[IN] the number of reads
+   * @return error code. RC_FILE_READ_FAILED if any read failed
+   */
+  RC readAll(Request* reqs, int n);
+
+  /**
+   * create the best implementation available.
+   * @param depth[IN] the maximum # of reads in flight
+   */
+  static AsyncIO* create(int depth);
+
+  /**
+   * @param depth[IN] the maximum # of reads in flight
+   * @return an io_uring based implementation, or NULL if the kernel has none
+   */
+  static AsyncIO* createUring(int depth);
+
+  /**
+   * @param threads[IN] the # of reading threads, i.e., of reads in flight
+   * @return a pread() based implementation
+   */
+  static AsyncIO* createThreadPool(int threads);
+};
+
+#endif // ASYNCIO_H
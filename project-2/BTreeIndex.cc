@@ -12,6 +12,11 @@
 
 static const PageId ROOT_PID = 0;
 
+// leaf and non-leaf nodes are allocated from different extents,
+// so that the leaf chain is not interrupted by non-leaf nodes
+static const int LEAF_GROUP    = 0;
+static const int NONLEAF_GROUP = 1;
+
 using namespace std;
 
 /*
@@ -38,11 +43,30 @@ RC BTreeIndex::open(const string& indexname, char mode)
     return rc;
   }
 
+  // nodes of version 1 files hold 32-bit page ids. such an index cannot
+  // be read, and SqlEngine::select() reports it instead of scanning the
+  // table. nodes did not change after version 2
+  if(pf.getFormatVersion() < 2) {
+    pf.close();
+    rootPid = INVALID_PID;
+    return RC_INVALID_FILE_FORMAT;
+  }
+
   rootPid = ROOT_PID;
 
-  // If the index has not been initialized, write an empty root (leaf) node
+  // New nodes are only allocated when writing
+  if((mode == 'w' || mode == 'W') && (rc = alloc.open(pf, indexname)) < 0) {
+    close();
+    return rc;
+  }
+
+  // If the index has not been initialized, write an empty root (leaf) node.
+  // The root is the first page allocated
   if(pf.endPid() <= 0) {
     BTLeafNode leaf;
+    PageId     pid;
+    if((rc = alloc.allocate(INVALID_PID, LEAF_GROUP, pid)) < 0)
+      return rc;
     return leaf.write(rootPid, pf);
   }
 
@@ -55,8 +79,11 @@ RC BTreeIndex::open(const string& indexname, char mode)
  */
 RC BTreeIndex::close()
 {
+  RC rc = alloc.close();
+
   rootPid = INVALID_PID;
-  return pf.close();
+  RC rc2 = pf.close();
+  return rc < 0 ? rc : rc2;
 }
 
 /*
@@ -67,6 +94,7 @@ RC BTreeIndex::close()
  */
 RC BTreeIndex::insert(int key, const RecordId& rid)
 {
+  unique_lock<shared_mutex> guard(treeLatch);
   RC     rc;
   PageId siblingPid      = INVALID_PID;
   int    siblingFirstKey = INVALID_KEY;
@@ -78,15 +106,19 @@ RC BTreeIndex::insert(int key, const RecordId& rid)
     return rc;
 
   // The root node needs a split!
-  const PageId  oldRootPid = pf.endPid();
+  PageId        oldRootPid;
   BTRawNonLeaf  oldRoot;
   BTNonLeafNode newRoot;
 
   // First we save the old root elsewhere on disk,
-  // so the new root can be saved as the first page
+  // so the new root can be saved as the first page.
+  // The old root moves next to its new sibling
   if((rc = oldRoot.read(rootPid, pf)) < 0)
     return rc;
 
+  if((rc = alloc.allocate(siblingPid, oldRoot.isLeaf() ? LEAF_GROUP : NONLEAF_GROUP, oldRootPid)) < 0)
+    return rc;
+
   // If we have a previously leaf root which splits
   // make sure that the sibling will point to the newly
   // moved leaf instead of at the new (non-leaf) root!
@@ -132,21 +164,34 @@ RC BTreeIndex::insert(int key, const RecordId& rid)
  */
 RC BTreeIndex::locate(int searchKey, IndexCursor& cursor) const
 {
+  shared_lock<shared_mutex> guard(treeLatch);
   RC rc = 0;
+  PinnedPage page; // Nodes are inspected in place in the page cache
+
   cursor.pid = rootPid;
-  BTRawNonLeaf rawNode; // Used to read in data and determine its type
 
   while(true) {
-    if((rc = rawNode.read(cursor.pid, pf)) < 0)
+    if((rc = page.pin(pf, cursor.pid)) < 0)
       return rc;
 
     // Found a leaf, try to pull the key out
-    if(rawNode.isLeaf()) {
-      BTLeafNode leaf(rawNode, cursor.pid);
-      return leaf.locate(searchKey, cursor.eid);
+    if(BTRawNonLeaf::fromPage(page.data()).isLeaf()) {
+      const BTRawLeaf& leaf = BTRawLeaf::fromPage(page.data());
+
+      cursor.eid = leaf.lowerBound(searchKey);
+      if((unsigned)cursor.eid < leaf.getKeyCount())
+        return 0;
+
+      cursor.eid = -1;
+      return RC_NO_SUCH_RECORD;
     } else { // Another non-leaf, keep traversing
-      BTNonLeafNode node(rawNode, cursor.pid);
-      if((rc = node.locateChildPtr(searchKey, cursor.pid)) < 0)
+      const BTRawNonLeaf& node = BTRawNonLeaf::fromPage(page.data());
+      const unsigned eid = node.upperBound(searchKey);
+      int key; // Placeholder
+
+      if(eid >= node.getKeyCount())
+        cursor.pid = node.getNextPid();
+      else if((rc = node.getPair(eid, key, cursor.pid)) < 0)
         return rc;
     }
   }
@@ -160,19 +205,21 @@ RC BTreeIndex::locate(int searchKey, IndexCursor& cursor) const
  * @return 0 on success, or an error code
  */
 RC BTreeIndex::locateFirstEntry(IndexCursor& cursor) const {
+  shared_lock<shared_mutex> guard(treeLatch);
   RC rc = 0;
-  BTRawNonLeaf rawNode; // Used to read in data and dtermine its type
+  PinnedPage page; // Nodes are inspected in place in the page cache
 
   cursor.pid = rootPid;
   cursor.eid = 0;
 
   while(true) {
-    if((rc = rawNode.read(cursor.pid, pf)) < 0)
+    if((rc = page.pin(pf, cursor.pid)) < 0)
       return rc;
 
+    const BTRawNonLeaf& rawNode = BTRawNonLeaf::fromPage(page.data());
+
     if(rawNode.isLeaf()) { // Found a leaf, return its pid or RC_END_OF_TREE if it is empty
-      BTLeafNode leaf(rawNode, cursor.pid);
-      return leaf.getKeyCount() > 0 ? 0 : RC_END_OF_TREE;
+      return BTRawLeaf::fromPage(page.data()).getKeyCount() > 0 ? 0 : RC_END_OF_TREE;
     } else { // Another node, grab its first page pointer
       int key; // Placeholder
       if((rc = rawNode.getPair(0, key, cursor.pid)) < 0)
@@ -193,16 +240,20 @@ RC BTreeIndex::locateFirstEntry(IndexCursor& cursor) const {
  */
 RC BTreeIndex::readForward(IndexCursor& cursor, int& key, RecordId& rid) const
 {
+  shared_lock<shared_mutex> guard(treeLatch);
   RC rc = 0;
-  BTLeafNode node;
+  PinnedPage page; // The leaf is read in place in the page cache
 
   while(true) {
     // Bail on load errors
-    if((rc = node.read(cursor.pid, pf)) < 0) {
-      return rc == RC_WRONG_NODE_TYPE ? RC_INVALID_CURSOR : rc;
-    }
+    if((rc = page.pin(pf, cursor.pid)) < 0)
+      return rc;
+
+    const BTRawLeaf& node = BTRawLeaf::fromPage(page.data());
+    if(!node.isLeaf())
+      return RC_INVALID_CURSOR;
 
-    rc = node.readEntry(cursor.eid, key, rid);
+    rc = node.getPair(cursor.eid, key, rid);
 
     // Exit on success or bail on unknown errors
     if(rc == 0) {
@@ -213,7 +264,7 @@ RC BTreeIndex::readForward(IndexCursor& cursor, int& key, RecordId& rid) const
     }
 
     // Record doesn't exist in the current node, fetch the next!
-    cursor.pid = node.getNextNodePtr();
+    cursor.pid = node.getNextPid();
     cursor.eid = 0;
 
     // Bail if no more nodes
@@ -286,8 +337,12 @@ RC BTreeIndex::insertRecursively(const PageId& nodePid, const int key, const Rec
       goto exit;
     }
 
-    // Save the leaf and its sibling on successful split
-    siblingPid = pf.endPid();
+    // Save the leaf and its sibling on successful split.
+    // The sibling follows the leaf in the leaf chain, so place it right
+    // after the leaf on disk to keep range scans sequential
+    if((rc = alloc.allocate(nodePid, LEAF_GROUP, siblingPid)) < 0) {
+      goto exit;
+    }
     if((rc = leafSibling->write(siblingPid, pf)) < 0) {
       goto exit;
     }
@@ -366,7 +421,9 @@ RC BTreeIndex::insertRecursively(const PageId& nodePid, const int key, const Rec
     goto exit;
   }
 
-  siblingPid = pf.endPid();
+  if((rc = alloc.allocate(nodePid, NONLEAF_GROUP, siblingPid)) < 0) {
+    goto exit;
+  }
   if((rc = nonLeafSibling->write(siblingPid, pf)) < 0) {
     goto exit;
   }
@@ -384,3 +441,70 @@ exit:
 
   return rc;
 }
+
+RC BTreeIndex::getHeight(int& height) const
+{
+  shared_lock<shared_mutex> guard(treeLatch);
+  RC rc;
+  PinnedPage page;
+  PageId pid = rootPid;
+
+  height = 0;
+  while(pid != INVALID_PID) {
+    if((rc = page.pin(pf, pid)) < 0)
+      return rc;
+    height++;
+
+    // Every path to a leaf is as long, so the first one will do
+    const BTRawNonLeaf& node = BTRawNonLeaf::fromPage(page.data());
+    if(node.isLeaf())
+      break;
+
+    int key; // Placeholder
+    if((rc = node.getPair(0, key, pid)) < 0)
+      return rc;
+  }
+
+  return 0;
+}
+
+RC BTreeIndex::prewarm(int maxPages, int& count) const
+{
+  shared_lock<shared_mutex> guard(treeLatch);
+  RC rc;
+  PinnedPage page;
+  std::vector<PageId> level(1, rootPid);
+
+  count = 0;
+  if(rootPid == INVALID_PID)
+    return 0;
+
+  while(!level.empty() && count + (int)level.size() <= maxPages) {
+    if((rc = pf.prewarm(level)) < 0)
+      return rc;
+    count += (int)level.size();
+
+    // The children of this level make up the next one; leaves have none
+    std::vector<PageId> children;
+    for(unsigned i = 0; i < level.size(); i++) {
+      if((rc = page.pin(pf, level[i])) < 0)
+        return rc;
+
+      const BTRawNonLeaf& node = BTRawNonLeaf::fromPage(page.data());
+      if(node.isLeaf())
+        break;
+
+      PageId child;
+      int key; // Placeholder
+      for(unsigned eid = 0; eid < node.getKeyCount(); eid++) {
+        if((rc = node.getPair(eid, key, child)) < 0)
+          return rc;
+        children.push_back(child);
+      }
+      children.push_back(node.getNextPid());
+    }
+    level.swap(children);
+  }
+
+  return 0;
+}
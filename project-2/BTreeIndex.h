@@ -10,9 +10,11 @@
 #ifndef BTREEINDEX_H
 #define BTREEINDEX_H
 
+#include <shared_mutex>
 #include "Bruinbase.h"
 #include "PageFile.h"
 #include "RecordFile.h"
+#include "PageAllocator.h"
              
 /**
  * The data structure to point to a particular entry at a b+tree leaf node.
@@ -29,7 +31,10 @@ typedef struct {
 
 /**
  * Implements a B-Tree index for bruinbase.
- * 
+ * every call but open() and close() may be made from several threads at
+ * once. insert() changes the tree alone; the other calls share it, each
+ * one at a time, so a cursor may miss or repeat entries moved by inserts
+ * made between two readForward() calls.
  */
 class BTreeIndex {
  public:
@@ -40,7 +45,8 @@ class BTreeIndex {
    * Under 'w' mode, the index file should be created if it does not exist.
    * @param indexname[IN] the name of the index file
    * @param mode[IN] 'r' for read, 'w' for write
-   * @return error code. 0 if no error
+   * @return error code. RC_INVALID_FILE_FORMAT if the index was written
+   *   in version 1 of the file format (see PageFile::FORMAT_VERSION)
    */
   RC open(const std::string& indexname, char mode);
 
@@ -96,10 +102,30 @@ class BTreeIndex {
    * @return error code. 0 if no error
    */
   RC readForward(IndexCursor& cursor, int& key, RecordId& rid) const;
+
+  /**
+   * Read the upper levels of the B+tree into the page cache, starting
+   * with the root and going down one level at a time for as long as the
+   * whole level fits. The pages of a level are read in pid order.
+   * @param maxPages[IN] the most pages to read
+   * @param count[OUT] the # of pages of the levels read
+   * @return error code. 0 if no error
+   */
+  RC prewarm(int maxPages, int& count) const;
+
+  /**
+   * Count the levels of the B+tree, from the root down to the leaves.
+   * @param height[OUT] the # of levels; 1 if the root is a leaf, 0 if
+   * the index is not open
+   * @return error code. 0 if no error
+   */
+  RC getHeight(int& height) const;
   
  private:
   PageFile pf;         /// the PageFile used to store the actual b+tree in disk
   PageId   rootPid;    /// the PageId of the root node
+  PageAllocator alloc; /// places new nodes next to their siblings ('w' mode only)
+  mutable std::shared_mutex treeLatch; /// held exclusively by insert(), shared by the readers
 
   /**
    * Traverses the B+tree recursively and creates any appropriate nodes along the way.
@@ -1,5 +1,9 @@
 #include "BTreeNode.h"
 
+// a node is read and written as exactly one page, whatever the page size
+static_assert(sizeof(BTRawLeaf) == PageFile::PAGE_SIZE, "a leaf node must fill a page");
+static_assert(sizeof(BTRawNonLeaf) == PageFile::PAGE_SIZE, "a non-leaf node must fill a page");
+
 using namespace std;
 
 /**
@@ -82,7 +86,7 @@ RC BTLeafNode::insert(int key, const RecordId& rid)
 RC BTLeafNode::insertAndSplit(int key, const RecordId& rid, 
                               BTLeafNode& sibling, int& siblingKey)
 {
-  RecordId placeHolder;
+  LeafRecordId placeHolder;
   return data.insertPairAndSplit(key, rid, sibling.data, siblingKey, placeHolder);
 }
 
@@ -95,14 +99,10 @@ RC BTLeafNode::insertAndSplit(int key, const RecordId& rid,
  * @return 0 if successful. Return an error code if there is an error.
  */
 RC BTLeafNode::locate(int searchKey, int& eid) const {
-  int key;
-  RecordId rid;
+  eid = data.lowerBound(searchKey);
 
-  for(eid = 0; (unsigned)eid < data.getKeyCount(); eid++) {
-    data.getPair(eid, key, rid);
-    if(key >= searchKey)
-      return 0;
-  }
+  if((unsigned)eid < data.getKeyCount())
+    return 0;
 
   eid = -1;
   return RC_NO_SUCH_RECORD;
@@ -205,6 +205,10 @@ RC BTNonLeafNode::insert(int key, PageId pid) {
   PageId   origPid;
   unsigned index;
 
+  // Leave a full node as it is, for insertAndSplit() to update
+  if(data.isFull())
+    return RC_NODE_FULL;
+
   // If the key is inserted at the end swap nextPid with pid to insert to keep the tree valid
   if(data.willBeInsertedAtEnd(key)) {
     if((rc = data.insertPair(key, data.getNextPid())) < 0)
@@ -247,13 +251,23 @@ RC BTNonLeafNode::insertAndSplit(int key, PageId pid, BTNonLeafNode& sibling, in
 {
   RC rc;
   PageId midPid;
+  int      oldKey;
+  PageId   origPid;
 
   // Make sure we properly update the nextPid if the new node will go at the end
   if(data.willBeInsertedAtEnd(key)) {
     rc = data.insertPairAndSplit(key, data.getNextPid(), sibling.data, midKey, midPid);
     sibling.data.setNextPid(pid);
   } else {
-    rc = data.insertPairAndSplit(key, pid, sibling.data, midKey, midPid);
+    // As in insert(), the pair that pointed to the old node now points to
+    // the sibling, and the key goes in front of it with the old node
+    if((rc = data.getPair(data.indexForInsert(key), oldKey, origPid)) < 0)
+      return rc;
+
+    if((rc = data.updatePair(oldKey, pid)) < 0)
+      return rc;
+
+    rc = data.insertPairAndSplit(key, origPid, sibling.data, midKey, midPid);
   }
 
   this->data.setNextPid(midPid);
@@ -269,17 +283,12 @@ RC BTNonLeafNode::insertAndSplit(int key, PageId pid, BTNonLeafNode& sibling, in
  */
 RC BTNonLeafNode::locateChildPtr(int searchKey, PageId& pid) const
 {
-  RC rc;
   int key;
+  unsigned eid = data.upperBound(searchKey);
 
-  for(unsigned eid = 0; eid < data.getKeyCount(); eid++) {
-    // Bail on errors
-    if((rc = data.getPair(eid, key, pid)) < 0)
-      return rc;
-
-    if(searchKey < key)
-      return 0;
-  }
+  // Follow the pointer left of the first larger key, or the last pointer
+  if(eid < data.getKeyCount())
+    return data.getPair(eid, key, pid);
 
   pid = data.getNextPid();
   return 0;
@@ -10,8 +10,11 @@
 #ifndef BTNODE_H
 #define BTNODE_H
 
+#include <climits>
+#include <cstring>
 #include "RecordFile.h"
 #include "PageFile.h"
+#include "KeySearch.h"
 
 #define MAX(a,b) ((a) > (b) ? (a) : (b))
 #define MIN(a,b) ((a) < (b) ? (a) : (b))
@@ -26,9 +29,10 @@ const int    INVALID_KEY = INT_MIN;
 /**
  * A simple glorified struct for holding raw BTNode data.
  * Wrapper class helps maintain the clean/dirty state, prevents
- * memory access violations, and handles loading data from disk
+ * memory access violations, and handles loading data from disk.
+ * Search is how the keys of the node are searched (see KeySearch.h)
  */
-template <typename Key, typename Value, Key INVALID_KEY>
+template <typename Key, typename Value, Key INVALID_KEY, typename Search = DefaultKeySearch>
 class BTRawNode {
   public:
     /**
@@ -42,8 +46,8 @@ class BTRawNode {
      * Copy constructor
      * @param node[IN] data to copy
      */
-    template <typename k2, typename v2, k2 m2>
-    BTRawNode(const BTRawNode<k2, v2, m2>& node) {
+    template <typename k2, typename v2, k2 m2, typename s2>
+    BTRawNode(const BTRawNode<k2, v2, m2, s2>& node) {
       memcpy(this, &node, sizeof(*this));
       countValidKeys(); // Recount keys since data was reinterpreted
     }
@@ -117,10 +121,11 @@ class BTRawNode {
      * Retreives a key value pair from the given index
      * @param eid[IN] the entry index to retrieve
      * @param k[OUT] retrieved key
-     * @param v[OUT] retrieved value
+     * @param v[OUT] retrieved value, converted from Value if need be
      * @return 0 on success, RC_NO_SUCH_RECORD on out of bounds eid or uninitialized entry
      */
-    RC getPair(unsigned eid, Key& k, Value& v) const {
+    template <typename V>
+    RC getPair(unsigned eid, Key& k, V& v) const {
       if(eid >= 0 && eid < MIN(pairCount, ARRAY_SIZE(keys))) {
         k = keys[eid];
         v = values[eid];
@@ -130,6 +135,34 @@ class BTRawNode {
       return RC_NO_SUCH_RECORD;
     }
 
+    /**
+     * Find the first entry whose key is larger than or equal to key
+     * @param key[IN] the key to search for
+     * @return the entry index, or getKeyCount() if every key is smaller
+     */
+    unsigned lowerBound(const Key& key) const {
+      return Search::lowerBound(keys, MIN(pairCount, ARRAY_SIZE(keys)), key);
+    }
+
+    /**
+     * Find the first entry whose key is strictly larger than key
+     * @param key[IN] the key to search for
+     * @return the entry index, or getKeyCount() if no key is larger
+     */
+    unsigned upperBound(const Key& key) const {
+      return Search::upperBound(keys, MIN(pairCount, ARRAY_SIZE(keys)), key);
+    }
+
+    /**
+     * Interpret a page pinned in the page cache as a node, without copying it.
+     * The node must not be used after the page is unpinned.
+     * @param page[IN] the pinned page content
+     * @return the node stored in the page
+     */
+    static const BTRawNode& fromPage(const char* page) {
+      return *reinterpret_cast<const BTRawNode*>(page);
+    }
+
     /**
      * Get the PageId of the next page.
      * @return returns PageId
@@ -146,6 +179,13 @@ class BTRawNode {
       return pairCount;
     }
 
+    /**
+     * @return true if no pair can be inserted without a split
+     */
+    bool isFull() const {
+      return pairCount >= ARRAY_SIZE(keys);
+    }
+
     /*************************************/
     /*************  Setters  *************/
     /*************************************/
@@ -245,7 +285,7 @@ class BTRawNode {
      * @param pivotKey[OUT] The key of the pivot element. Will be inserted into sibling for leaf nodes, but not for non-leaf nodes
      * @param pivotValue[OUT] The value of the pivot element. Will be inserted into sibling for leaf nodes, but not for non-leaf nodes
      */
-    RC insertPairAndSplit(const Key& key, const Value& value, BTRawNode<Key, Value, INVALID_KEY>& sibling, Key& pivotKey, Value& pivotValue) {
+    RC insertPairAndSplit(const Key& key, const Value& value, BTRawNode<Key, Value, INVALID_KEY, Search>& sibling, Key& pivotKey, Value& pivotValue) {
       RC     rc;
 
       // Variables to hold the overflow pair
@@ -358,33 +398,8 @@ class BTRawNode {
      *         than ARRAY_SIZE(keys) the key should be inserted in a new node.
      */
     unsigned indexForInsert(const Key& key) const {
-      unsigned lo = 0;
-      unsigned hi = MIN(pairCount, ARRAY_SIZE(keys)) - 1;
-      unsigned cur = lo;
-
-      while(lo < hi) {
-        if(key < keys[lo]) {
-          cur = lo;
-          break;
-        } else if(key >= keys[hi]) {
-          cur = hi;
-          break;
-        } else {
-          cur = (hi + lo) / 2;
-        }
-
-        if(key == keys[cur])
-          break;
-        else if(key < keys[cur])
-          hi = --cur;
-        else // key > keys[cur]
-          lo = ++cur;
-      }
-
-      if(keys[cur] != INVALID_KEY && key >= keys[cur])
-        cur++;
-
-      return cur;
+      // after the keys equal to it, so that equal keys keep their order
+      return upperBound(key);
     }
 
   protected:
@@ -413,6 +428,9 @@ class BTRawNode {
      */
     static const unsigned DEGREE = (PageFile::PAGE_SIZE - sizeof(PageId) - sizeof(short) - sizeof(short)) / (sizeof(Key) + sizeof(Value));
 
+    // pairCount must be able to count every entry of the largest page
+    static_assert(DEGREE <= USHRT_MAX, "the page size is too large for a node");
+
     /**
      * Note: if we used an int for flags, it is possible to not need any padding
      * as the maximum page size will be word aligned. Since a zero sized array is forbidden
@@ -425,14 +443,39 @@ class BTRawNode {
     char    padding[PageFile::PAGE_SIZE - DEGREE*(sizeof(Key) + sizeof(Value)) - sizeof(PageId) - sizeof(short) - sizeof(short)];
 
     // Shared entries should always be after the padding so that
-    // they are always aligned between different node types
-    PageId  nextPid;
+    // they are always aligned between different node types.
+    // nextPid comes last so that it is 8-byte aligned at the end of the page
     unsigned short pairCount; // Cache the number of useful entries
     unsigned short flags;
+    PageId  nextPid;
+};
+
+/**
+ * A RecordId as stored in a leaf node. The page id takes the upper 48 bits
+ * and the slot number the lower 16, so that a leaf entry stays 12 bytes
+ * long although page ids are 64-bit. Converts to and from RecordId.
+ */
+class LeafRecordId {
+  public:
+    LeafRecordId() = default;
+    LeafRecordId(const RecordId& rid)
+      : bits(((unsigned long long)rid.pid << 16) | (unsigned short)rid.sid) { }
+
+    operator RecordId() const {
+      RecordId rid;
+      rid.pid = (PageId)((long long)bits >> 16);
+      rid.sid = (int)(bits & 0xffff);
+      return rid;
+    }
+
+  private:
+    unsigned long long bits;
 };
 
-typedef BTRawNode<int, RecordId, INVALID_KEY> BTRawLeaf;
-typedef BTRawNode<int, PageId,   INVALID_KEY> BTRawNonLeaf;
+static_assert(RecordFile::RECORDS_PER_PAGE <= 0xffff, "a leaf entry cannot hold the slot number");
+
+typedef BTRawNode<int, LeafRecordId, INVALID_KEY> BTRawLeaf;
+typedef BTRawNode<int, PageId,       INVALID_KEY> BTRawNonLeaf;
 
 /**
  * BTLeafNode: The class representing a B+tree leaf node.
@@ -448,8 +491,8 @@ class BTLeafNode {
      * @param node[IN] raw data in memory to use
      * @param pid[IN] PageId with which the data should be associated
      */
-    template<typename k, typename v, k m>
-    BTLeafNode(const BTRawNode<k, v, m>& node, const PageId& pid) : data(node), dataPid(pid)
+    template<typename k, typename v, k m, typename s>
+    BTLeafNode(const BTRawNode<k, v, m, s>& node, const PageId& pid) : data(node), dataPid(pid)
     {}
 
    /**
@@ -550,8 +593,8 @@ class BTNonLeafNode {
      * @param node[IN] raw data in memory to use
      * @param pid[IN] PageId with which the data should be associated
      */
-    template <typename k, typename v, k m>
-    BTNonLeafNode(const BTRawNode<k, v, m>& node, const PageId& pid) : data(node), dataPid(pid)
+    template <typename k, typename v, k m, typename s>
+    BTNonLeafNode(const BTRawNode<k, v, m, s>& node, const PageId& pid) : data(node), dataPid(pid)
     {}
 
    /**
@@ -11,6 +11,7 @@
 #define BRUINBASE_H
 
 typedef int RC;
+typedef long long PageId; // 64-bit, so that files may grow beyond 2GB
 
 const int RC_FILE_OPEN_FAILED    = -1001;
 const int RC_FILE_CLOSE_FAILED   = -1002;
@@ -29,5 +30,7 @@ const int RC_INVALID_ATTRIBUTE   = -1014;
 const int RC_WRONG_NODE_TYPE     = -1015;
 const int RC_INSERT_NEEDS_SPLIT  = -1016;
 const int RC_OUT_OF_MEMORY       = -1017;
+const int RC_NO_FREE_FRAME       = -1018;
+const int RC_INVALID_SCHEMA      = -1019;
 
 #endif // BRUINBASE_H
@@ -0,0 +1,611 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/17/2026
+ */
+
+#include <new>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <climits>
+#include <sys/uio.h>
+#include "BufferPool.h"
+
+//
+// LRU replacement
+//
+
+void LRUPolicy::reset(int frameCount)
+{
+  prev.assign(frameCount, -1);
+  next.assign(frameCount, -1);
+  linked.assign(frameCount, false);
+  head = tail = -1;
+}
+
+void LRUPolicy::unlink(int frame)
+{
+  if (prev[frame] >= 0) next[prev[frame]] = next[frame];
+  else head = next[frame];
+
+  if (next[frame] >= 0) prev[next[frame]] = prev[frame];
+  else tail = prev[frame];
+
+  prev[frame] = next[frame] = -1;
+  linked[frame] = false;
+}
+
+void LRUPolicy::touch(int frame)
+{
+  if (linked[frame]) {
+    if (frame == head) return;
+    unlink(frame);
+  }
+
+  // put the frame at the most recently used end of the list
+  next[frame] = head;
+  prev[frame] = -1;
+  if (head >= 0) prev[head] = frame;
+  head = frame;
+  if (tail < 0) tail = frame;
+  linked[frame] = true;
+}
+
+void LRUPolicy::remove(int frame)
+{
+  if (linked[frame]) unlink(frame);
+}
+
+int LRUPolicy::victim()
+{
+  return tail;
+}
+
+//
+// CLOCK replacement
+//
+
+void ClockPolicy::reset(int frameCount)
+{
+  state.assign(frameCount, 0);
+  hand = 0;
+  occupied = 0;
+}
+
+void ClockPolicy::touch(int frame)
+{
+  if (state[frame] == 0) occupied++;
+  state[frame] = 2;
+}
+
+void ClockPolicy::remove(int frame)
+{
+  if (state[frame] != 0) occupied--;
+  state[frame] = 0;
+}
+
+int ClockPolicy::victim()
+{
+  if (occupied == 0) return -1;
+
+  // at most two sweeps: the first one may only clear reference bits
+  for (;;) {
+    int frame = hand;
+    hand = (hand + 1) % (int)state.size();
+
+    if (state[frame] == 1) return frame;
+    if (state[frame] == 2) state[frame] = 1;
+  }
+}
+
+//
+// page latches
+//
+
+// the latches the calling thread holds shared, once per hold
+static thread_local std::vector<const PageLatch*> sharedHolds;
+
+int PageLatch::heldShared() const
+{
+  int n = 0;
+
+  for (unsigned i = 0; i < sharedHolds.size(); i++) {
+    if (sharedHolds[i] == this) n++;
+  }
+  return n;
+}
+
+void PageLatch::lockShared()
+{
+  int s = state.load();
+
+  // join the other readers unless a writer holds the latch
+  for (;;) {
+    if (s >= 0 && state.compare_exchange_weak(s, s + 1)) break;
+    if (s < 0) {
+      std::this_thread::yield();
+      s = state.load();
+    }
+  }
+  sharedHolds.push_back(this);
+}
+
+void PageLatch::unlockShared()
+{
+  for (unsigned i = sharedHolds.size(); i-- > 0; ) {
+    if (sharedHolds[i] == this) {
+      sharedHolds.erase(sharedHolds.begin() + i);
+      break;
+    }
+  }
+  state.fetch_sub(1);
+}
+
+void PageLatch::lock()
+{
+  // wait until the only readers left are the holds of this thread
+  const int own = heldShared();
+  int expected = own;
+
+  while (!state.compare_exchange_weak(expected, -1)) {
+    expected = own;
+    std::this_thread::yield();
+  }
+}
+
+void PageLatch::unlock()
+{
+  state.store(heldShared());
+}
+
+//
+// the buffer pool
+//
+
+BufferPool::BufferPool(int pageSize, int frameCount)
+: pageSize(pageSize), data(NULL), frames(NULL), nFrames(0), policy(new LRUPolicy),
+  hitCount(0), missCount(0), evictCount(0), writeBackCount(0), prefetchCount(0)
+{
+  resize(frameCount);
+}
+
+BufferPool::~BufferPool()
+{
+  free(data);
+  delete [] frames;
+  delete policy;
+}
+
+RC BufferPool::resize(int frameCount)
+{
+  RC rc;
+  Guard guard(latch);
+
+  if (frameCount < 1) return RC_INVALID_ATTRIBUTE;
+  while (!dirtyPages.empty()) {
+    if ((rc = flushLocked(dirtyPages.begin()->first)) < 0) return rc;
+  }
+
+  // the frames are aligned so that they can be used for O_DIRECT transfers
+  void*  newData = NULL;
+  Frame* newFrames = new (std::nothrow) Frame[frameCount];
+  if (posix_memalign(&newData, FRAME_ALIGNMENT, (size_t)frameCount * pageSize) != 0) newData = NULL;
+  if (newData == NULL || newFrames == NULL) {
+    free(newData);
+    delete [] newFrames;
+    return RC_OUT_OF_MEMORY;
+  }
+
+  free(data);
+  delete [] frames;
+  data = (char*)newData;
+  frames = newFrames;
+  nFrames = frameCount;
+  clear();
+
+  return 0;
+}
+
+RC BufferPool::dropAll()
+{
+  RC rc;
+  Guard guard(latch);
+
+  while (!dirtyPages.empty()) {
+    if ((rc = flushLocked(dirtyPages.begin()->first)) < 0) return rc;
+  }
+  clear();
+
+  return 0;
+}
+
+RC BufferPool::setPolicy(ReplacementPolicy* newPolicy)
+{
+  RC rc;
+  Guard guard(latch);
+
+  if (newPolicy == NULL) return RC_INVALID_ATTRIBUTE;
+  while (!dirtyPages.empty()) {
+    if ((rc = flushLocked(dirtyPages.begin()->first)) < 0) {
+      delete newPolicy;
+      return rc;
+    }
+  }
+
+  delete policy;
+  policy = newPolicy;
+  clear();
+
+  return 0;
+}
+
+void BufferPool::clear()
+{
+  table.clear();
+  table.reserve(nFrames);
+  policy->reset(nFrames);
+
+  // hand out the low frames first
+  freeFrames.resize(nFrames);
+  for (int i = 0; i < nFrames; i++) {
+    frames[i].used = false;
+    frames[i].loading = false;
+    frames[i].dirty = false;
+    frames[i].pins = 0;
+    freeFrames[i] = nFrames - 1 - i;
+  }
+}
+
+RC BufferPool::claim(Guard& guard, const PageKey& key, int& frame, bool& cached)
+{
+  RC rc;
+
+  // the page may already be cached. if another thread is still reading it
+  // from disk, wait for it; the read may fail and the frame be released
+  for (;;) {
+    std::unordered_map<PageKey, int, PageKeyHash>::const_iterator it = table.find(key);
+    if (it == table.end()) break;
+
+    if (!frames[it->second].loading) {
+      frame = it->second;
+      cached = true;
+      return 0;
+    }
+    loaded.wait(guard);
+  }
+
+  // take a free frame if there is one, otherwise evict
+  if (!freeFrames.empty()) {
+    frame = freeFrames.back();
+    freeFrames.pop_back();
+  } else {
+    if ((frame = policy->victim()) < 0) return RC_NO_FREE_FRAME;
+
+    // a dirty victim is written back along with its dirty neighbours,
+    // which stay cached but become clean
+    if (frames[frame].dirty) {
+      const PageKey& victim = frames[frame].key;
+      std::set<PageId>& dirty = dirtyPages[victim.fid];
+      std::set<PageId>::iterator first = dirty.find(victim.pid);
+      std::set<PageId>::iterator last = first;
+      std::set<PageId>::iterator i;
+
+      // extend the run over the consecutive dirty pages on both sides
+      while (first != dirty.begin()) {
+        i = first;
+        if (*--i != *first - 1 || *last - *i >= IOV_MAX) break;
+        first = i;
+      }
+      while (++(i = last) != dirty.end()) {
+        if (*i != *last + 1 || *i - *first >= IOV_MAX) break;
+        last = i;
+      }
+      if ((rc = writeBack(victim.fid, *first, *last)) < 0) return rc;
+    }
+
+    counters[frames[frame].key.fid].evictions++;
+    table.erase(frames[frame].key);
+    policy->remove(frame);
+    evictCount++;
+  }
+
+  frames[frame].key = key;
+  frames[frame].used = true;
+  frames[frame].loading = false;
+  frames[frame].dirty = false;
+  frames[frame].pins = 0;
+  table[key] = frame;
+  policy->touch(frame);
+  cached = false;
+
+  return 0;
+}
+
+RC BufferPool::pin(int fid, PageId pid, const PageStore* store, char*& page)
+{
+  RC    rc;
+  int   frame;
+  bool  cached;
+  PageKey key = { fid, pid };
+  Guard guard(latch);
+
+  if ((rc = claim(guard, key, frame, cached)) < 0) return rc;
+
+  // a pinned frame is invisible to the replacement policy
+  Frame& f = frames[frame];
+  if (f.pins++ == 0) policy->remove(frame);
+
+  if (cached) {
+    hitCount++;
+    counters[fid].hits++;
+  } else {
+    // read the page without holding the pool latch. other threads that
+    // want the same page wait until it is loaded
+    missCount++;
+    counters[fid].misses++;
+    f.loading = true;
+    guard.unlock();
+    rc = store->readPage(pid, pageOf(frame));
+    guard.lock();
+
+    f.loading = false;
+    loaded.notify_all();
+    if (rc < 0) {
+      f.pins = 0;
+      release(frame);
+      return rc;
+    }
+  }
+  guard.unlock();
+
+  // keep writers out of the page while it is pinned
+  f.latch.lockShared();
+  page = pageOf(frame);
+
+  return 0;
+}
+
+RC BufferPool::prefetch(int fid, const PageId* pids, int n, const PageStore* store)
+{
+  RC    rc;
+  int   frame;
+  bool  cached;
+  std::vector<int>    loading;
+  std::vector<PageId> loadPids;
+  std::vector<char*>  loadPages;
+  Guard guard(latch);
+
+  // leave at least half of the pool to the pages that are pinned meanwhile
+  for (int i = 0; i < n && (int)loading.size() < nFrames / 2; i++) {
+    PageKey key = { fid, pids[i] };
+    if (table.find(key) != table.end()) continue;
+    if (claim(guard, key, frame, cached) < 0) break;
+    if (cached) continue;
+
+    // the frames are pinned and loading until the batch completes
+    frames[frame].pins = 1;
+    frames[frame].loading = true;
+    policy->remove(frame);
+
+    loading.push_back(frame);
+    loadPids.push_back(pids[i]);
+    loadPages.push_back(pageOf(frame));
+  }
+  if (loading.empty()) return 0;
+
+  guard.unlock();
+  rc = store->readPages(&loadPids[0], &loadPages[0], (int)loading.size());
+  guard.lock();
+
+  for (unsigned i = 0; i < loading.size(); i++) {
+    Frame& f = frames[loading[i]];
+    f.loading = false;
+    f.pins = 0;
+    if (rc < 0) release(loading[i]);
+    else policy->touch(loading[i]);
+  }
+  loaded.notify_all();
+  if (rc < 0) return rc;
+
+  prefetchCount += (long long)loading.size();
+  counters[fid].prefetches += (long long)loading.size();
+  return 0;
+}
+
+void BufferPool::unpin(const char* page)
+{
+  int frame = frameOf(page);
+  Frame& f = frames[frame];
+
+  f.latch.unlockShared();
+
+  Guard guard(latch);
+  if (f.pins > 0 && --f.pins == 0) policy->touch(frame);
+}
+
+RC BufferPool::write(int fid, PageId pid, const void* buffer)
+{
+  RC    rc;
+  int   frame;
+  bool  cached;
+  PageKey key = { fid, pid };
+  Guard guard(latch);
+
+  if ((rc = claim(guard, key, frame, cached)) < 0) return rc;
+
+  // keep the frame from being evicted, and a new frame from being read
+  // by others, while the page is copied in
+  Frame& f = frames[frame];
+  if (f.pins++ == 0) policy->remove(frame);
+  if (!cached) f.loading = true;
+  guard.unlock();
+
+  f.latch.lock();
+  memcpy(pageOf(frame), buffer, pageSize);
+  f.latch.unlock();
+
+  guard.lock();
+  if (!cached) {
+    f.loading = false;
+    loaded.notify_all();
+  }
+  if (!f.dirty) {
+    f.dirty = true;
+    dirtyPages[fid].insert(pid);
+  }
+  if (--f.pins == 0) policy->touch(frame);
+
+  return 0;
+}
+
+void BufferPool::update(int fid, PageId pid, const void* buffer)
+{
+  PageKey key = { fid, pid };
+  Guard guard(latch);
+  int frame;
+
+  // wait for a pending read of the page; it may have read the old version
+  for (;;) {
+    std::unordered_map<PageKey, int, PageKeyHash>::const_iterator it = table.find(key);
+    if (it == table.end()) return;
+
+    frame = it->second;
+    if (!frames[frame].loading) break;
+    loaded.wait(guard);
+  }
+
+  Frame& f = frames[frame];
+  if (f.pins++ == 0) policy->remove(frame);
+  guard.unlock();
+
+  f.latch.lock();
+  memcpy(pageOf(frame), buffer, pageSize);
+  f.latch.unlock();
+
+  guard.lock();
+  if (--f.pins == 0) policy->touch(frame);
+}
+
+void BufferPool::setStore(int fid, PageStore* store)
+{
+  Guard guard(latch);
+
+  if (store != NULL) stores[fid] = store;
+  else stores.erase(fid);
+}
+
+RC BufferPool::writeBack(int fid, PageId first, PageId last)
+{
+  RC rc;
+  std::vector<const char*> pages;
+  std::vector<int> runFrames;
+  std::unordered_map<int, PageStore*>::iterator store = stores.find(fid);
+
+  if (store == stores.end()) return RC_FILE_WRITE_FAILED;
+
+  // collect the frames of the run and write them in one request.
+  // the pages are latched so that no writer changes them halfway
+  for (PageId pid = first; pid <= last; pid++) {
+    PageKey key = { fid, pid };
+    int frame = table[key];
+
+    frames[frame].latch.lockShared();
+    runFrames.push_back(frame);
+    pages.push_back(pageOf(frame));
+  }
+  rc = store->second->writePages(first, &pages[0], (int)pages.size());
+  for (unsigned i = 0; i < runFrames.size(); i++) {
+    frames[runFrames[i]].latch.unlockShared();
+  }
+  if (rc < 0) return rc;
+
+  // the pages are clean now
+  std::set<PageId>& dirty = dirtyPages[fid];
+  for (PageId pid = first; pid <= last; pid++) {
+    frames[runFrames[pid - first]].dirty = false;
+    dirty.erase(pid);
+  }
+  writeBackCount += (long long)pages.size();
+  counters[fid].writeBacks += (long long)pages.size();
+
+  return 0;
+}
+
+RC BufferPool::flushLocked(int fid)
+{
+  RC rc;
+  std::unordered_map<int, std::set<PageId> >::iterator it = dirtyPages.find(fid);
+
+  if (it == dirtyPages.end()) return 0;
+
+  // write back the dirty pages in order, one run of consecutive pages at a time
+  std::set<PageId>& dirty = it->second;
+  while (!dirty.empty()) {
+    std::set<PageId>::iterator i = dirty.begin();
+    PageId first = *i;
+    PageId last = first;
+
+    while (++i != dirty.end() && *i == last + 1 && *i - first < IOV_MAX) {
+      last = *i;
+    }
+    if ((rc = writeBack(fid, first, last)) < 0) return rc;
+  }
+
+  dirtyPages.erase(it);
+  return 0;
+}
+
+RC BufferPool::flush(int fid)
+{
+  Guard guard(latch);
+  return flushLocked(fid);
+}
+
+RC BufferPool::flushAll()
+{
+  RC rc;
+  Guard guard(latch);
+
+  while (!dirtyPages.empty()) {
+    if ((rc = flushLocked(dirtyPages.begin()->first)) < 0) return rc;
+  }
+
+  return 0;
+}
+
+BufferPool::FileCounters BufferPool::getFileCounters(int fid)
+{
+  Guard guard(latch);
+  return counters[fid];
+}
+
+void BufferPool::getCachedPages(std::vector<PageKey>& keys)
+{
+  Guard guard(latch);
+
+  keys.clear();
+  for (int i = 0; i < nFrames; i++) {
+    if (frames[i].used && !frames[i].loading) keys.push_back(frames[i].key);
+  }
+}
+
+void BufferPool::release(int frame)
+{
+  if (frames[frame].dirty) dirtyPages[frames[frame].key.fid].erase(frames[frame].key.pid);
+  frames[frame].dirty = false;
+  table.erase(frames[frame].key);
+  policy->remove(frame);
+  frames[frame].used = false;
+  freeFrames.push_back(frame);
+}
+
+void BufferPool::invalidateFile(int fid)
+{
+  Guard guard(latch);
+
+  for (int i = 0; i < nFrames; i++) {
+    if (frames[i].used && frames[i].pins == 0 && frames[i].key.fid == fid) release(i);
+  }
+}
@@ -0,0 +1,395 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/17/2026
+ */
+
+#ifndef BUFFERPOOL_H
+#define BUFFERPOOL_H
+
+#include <cstddef>
+#include <set>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include "Bruinbase.h"
+
+/**
+ * Identifies a cached page: the pool-wide id of the file it belongs to
+ * (see PageFile::open) and the page number inside that file.
+ */
+struct PageKey {
+  int    fid;
+  PageId pid;
+
+  bool operator== (const PageKey& other) const {
+    return fid == other.fid && pid == other.pid;
+  }
+};
+
+struct PageKeyHash {
+  size_t operator() (const PageKey& k) const {
+    return (size_t)k.pid * 0x9E3779B97F4A7C15ULL ^ (size_t)k.fid;
+  }
+};
+
+/**
+ * The backing store of the pages of a file.
+ * The pool reads missing pages from it, and hands it runs of consecutive
+ * dirty pages so that they can be written with a single request.
+ */
+class PageStore {
+ public:
+  virtual ~PageStore() {}
+
+  /**
+   * read a page from disk.
+   * @param pid[IN] the page to read
+   * @param page[OUT] the buffer to read the page into
+   * @return error code. 0 if no error
+   */
+  virtual RC readPage(PageId pid, char* page) const = 0;
+
+  /**
+   * read several pages from disk. stores that can have many reads in
+   * flight at once should override this; by default the pages are read
+   * one after the other.
+   * @param pids[IN] the pages to read
+   * @param pages[OUT] the buffer to read each page into
+   * @param n[IN] the number of pages
+   * @return error code. 0 if no error
+   */
+  virtual RC readPages(const PageId* pids, char* const* pages, int n) const {
+    RC rc;
+    for (int i = 0; i < n; i++) {
+      if ((rc = readPage(pids[i], pages[i])) < 0) return rc;
+    }
+    return 0;
+  }
+
+  /**
+   * write n consecutive pages to disk, the first one being page pid.
+   * @param pid[IN] the id of the first page
+   * @param pages[IN] the content of each page
+   * @param n[IN] the number of pages
+   * @return error code. 0 if no error
+   */
+  virtual RC writePages(PageId pid, const char* const* pages, int n) = 0;
+};
+
+/**
+ * Decides which occupied frame of a BufferPool should be evicted.
+ * The pool notifies the policy of every access to, and removal of, a frame.
+ * Pinned frames are removed from the policy until they are unpinned.
+ * The pool serializes all calls to the policy.
+ */
+class ReplacementPolicy {
+ public:
+  virtual ~ReplacementPolicy() {}
+
+  /**
+   * forget all state and prepare to track frameCount frames.
+   * @param frameCount[IN] the number of frames in the pool
+   */
+  virtual void reset(int frameCount) = 0;
+
+  /**
+   * a frame was filled or accessed.
+   * @param frame[IN] the frame number
+   */
+  virtual void touch(int frame) = 0;
+
+  /**
+   * a frame was emptied and must not be chosen as a victim.
+   * @param frame[IN] the frame number
+   */
+  virtual void remove(int frame) = 0;
+
+  /**
+   * @return the frame to evict next, or -1 if no frame is occupied
+   */
+  virtual int victim() = 0;
+
+  /**
+   * @return the short name of the policy ("lru", "clock", ...)
+   */
+  virtual const char* name() const = 0;
+};
+
+/**
+ * Least recently used: evict the frame whose last access is the oldest.
+ * Frames are kept in a doubly linked list ordered by recency.
+ */
+class LRUPolicy : public ReplacementPolicy {
+ public:
+  void reset(int frameCount);
+  void touch(int frame);
+  void remove(int frame);
+  int  victim();
+  const char* name() const { return "lru"; }
+
+ private:
+  void unlink(int frame);
+
+  std::vector<int>  prev;    // neighbour towards the most recently used end
+  std::vector<int>  next;    // neighbour towards the least recently used end
+  std::vector<bool> linked;  // whether the frame is in the list
+  int head;                  // most recently used frame
+  int tail;                  // least recently used frame
+};
+
+/**
+ * CLOCK (second chance): a hand sweeps over the frames, clearing reference
+ * bits, and evicts the first occupied frame whose bit is already clear.
+ */
+class ClockPolicy : public ReplacementPolicy {
+ public:
+  void reset(int frameCount);
+  void touch(int frame);
+  void remove(int frame);
+  int  victim();
+  const char* name() const { return "clock"; }
+
+ private:
+  std::vector<unsigned char> state; // 0: empty, 1: occupied, 2: occupied and referenced
+  int hand;                         // the next frame to inspect
+  int occupied;                     // # of occupied frames
+};
+
+/**
+ * A reader/writer latch protecting the content of one frame.
+ * Readers hold it shared for as long as they pin the page; a writer holds
+ * it exclusively while it copies a new version of the page in. A writer
+ * that has pinned the page itself upgrades its own shared holds instead of
+ * waiting for them, and gets them back when it unlocks. Two threads that
+ * both pin a page must not both write it; the B+tree and the record files
+ * serialize their writers. Waiters spin, as the exclusive section is a
+ * single page copy.
+ */
+class PageLatch {
+ public:
+  PageLatch() : state(0) {}
+
+  void lockShared();
+  void unlockShared();
+  void lock();
+  void unlock();
+
+ private:
+  /**
+   * @return the # of times the calling thread holds the latch shared
+   */
+  int heldShared() const;
+
+  std::atomic<int> state; // # of readers, or -1 when held by a writer
+};
+
+/**
+ * A fixed number of page-sized frames shared by every PageFile.
+ * Pages are located through a hash table keyed by (fid, pid), and the
+ * frame to reuse when the pool is full is chosen by a ReplacementPolicy.
+ * Frames may hold dirty pages, which are written back to the PageStore
+ * of their file when they are evicted or flushed.
+ *
+ * All operations may be called from several threads at once. The pool
+ * bookkeeping is protected by a single latch which is not held while a
+ * missing page is read from disk; other threads asking for the same page
+ * wait for that read instead of issuing their own.
+ */
+class BufferPool {
+ public:
+  /**
+   * what the pool did for the pages of one file
+   */
+  struct FileCounters {
+    long long hits;       // pins satisfied from the pool
+    long long misses;     // pins that had to read the page
+    long long evictions;  // pages of the file dropped to make room
+    long long prefetches; // pages read by prefetch()
+    long long writeBacks; // dirty pages written back
+  };
+
+  /**
+   * @param pageSize[IN] the size of a frame in bytes
+   * @param frameCount[IN] the initial number of frames
+   */
+  BufferPool(int pageSize, int frameCount);
+  ~BufferPool();
+
+  /**
+   * write back every dirty page, drop every cached page and
+   * change the number of frames. no page may be pinned.
+   * @param frameCount[IN] the new number of frames (at least 1)
+   * @return error code. 0 if no error
+   */
+  RC resize(int frameCount);
+
+  /**
+   * write back every dirty page and drop every cached page, e.g., to
+   * measure reads from a cold cache. no page may be pinned.
+   * @return error code. 0 if no error
+   */
+  RC dropAll();
+
+  /**
+   * write back every dirty page, drop every cached page and
+   * switch to a different replacement policy. no page may be pinned.
+   * the pool takes ownership of the policy object.
+   * @param policy[IN] the new policy
+   * @return error code. 0 if no error
+   */
+  RC setPolicy(ReplacementPolicy* policy);
+
+  /**
+   * pin a page, reading it from its store if it is not cached.
+   * the page is not evicted, and not modified, until it is unpinned.
+   * a page may be pinned several times, by several threads.
+   * if a dirty page has to be evicted to make room, it is written back
+   * first, together with the dirty pages of the same file that directly
+   * precede and follow it.
+   * @param fid[IN] the file the page belongs to
+   * @param pid[IN] the page to pin
+   * @param store[IN] where to read the page from if it is not cached
+   * @param page[OUT] the cached page content
+   * @return error code. RC_NO_FREE_FRAME if every frame is pinned
+   */
+  RC pin(int fid, PageId pid, const PageStore* store, char*& page);
+
+  /**
+   * read the pages that are not cached yet into the pool with one batch
+   * of reads, so that later pins find them. this is only a hint: pages
+   * are skipped when no frame can be spared for them.
+   * @param fid[IN] the file the pages belong to
+   * @param pids[IN] the pages to read
+   * @param n[IN] the number of pages
+   * @param store[IN] where to read the pages from
+   * @return error code. 0 if no error
+   */
+  RC prefetch(int fid, const PageId* pids, int n, const PageStore* store);
+
+  /**
+   * release one pin of a page.
+   * @param page[IN] the page content as returned by pin()
+   */
+  void unpin(const char* page);
+
+  /**
+   * replace the content of a page in the pool and mark it dirty. it is
+   * written back to the store registered for its file on eviction or flush().
+   * the calling thread must not have the page pinned.
+   * @param fid[IN] the file the page belongs to
+   * @param pid[IN] the page to write
+   * @param buffer[IN] the new page content
+   * @return error code. 0 if no error
+   */
+  RC write(int fid, PageId pid, const void* buffer);
+
+  /**
+   * replace the content of a page if it is cached, e.g., after the page
+   * was written to disk directly. the page stays clean.
+   * the calling thread must not have the page pinned.
+   * @param fid[IN] the file the page belongs to
+   * @param pid[IN] the page to update
+   * @param buffer[IN] the new page content
+   */
+  void update(int fid, PageId pid, const void* buffer);
+
+  /**
+   * register where the dirty pages of a file are written back to.
+   * @param fid[IN] the file
+   * @param store[IN] the store of the file, or NULL to unregister it
+   */
+  void setStore(int fid, PageStore* store);
+
+  /**
+   * write back every dirty page of a file. runs of consecutive pages
+   * are written with one request.
+   * @param fid[IN] the file to flush
+   * @return error code. 0 if no error
+   */
+  RC flush(int fid);
+
+  /**
+   * write back every dirty page in the pool.
+   * @return error code. 0 if no error
+   */
+  RC flushAll();
+
+  /**
+   * drop every cached page of a file. pinned pages are left alone.
+   * @param fid[IN] the file to drop
+   */
+  void invalidateFile(int fid);
+
+  int frameCount() const      { return nFrames; }
+  const char* policyName() const { return policy->name(); }
+
+  long long getHitCount() const       { return hitCount; }
+  long long getMissCount() const      { return missCount; }
+  long long getEvictionCount() const  { return evictCount; }
+  long long getWriteBackCount() const { return writeBackCount; }
+  long long getPrefetchCount() const  { return prefetchCount; }
+
+  /**
+   * @param fid[IN] the file
+   * @return what the pool did for the pages of the file so far
+   */
+  FileCounters getFileCounters(int fid);
+
+  /**
+   * list the pages the pool holds, e.g., to read them back into the
+   * pool of a later process. pages still being read are left out.
+   * @param keys[OUT] the cached pages, in no particular order
+   */
+  void getCachedPages(std::vector<PageKey>& keys);
+
+  // the alignment of every frame whose page size is a multiple of it,
+  // as required for O_DIRECT transfers. smaller pages are aligned to their size
+  static const size_t FRAME_ALIGNMENT = 4096;
+
+ private:
+  struct Frame {
+    PageKey   key;     // the page held by the frame
+    bool      used;    // false if the frame is free
+    bool      loading; // true while the page is being read from disk
+    bool      dirty;   // whether the page differs from the one on disk
+    int       pins;    // # of outstanding pins; pinned frames are never evicted
+    PageLatch latch;   // protects the page content
+  };
+
+  typedef std::unique_lock<std::mutex> Guard;
+
+  void clear();
+  void release(int frame);
+  RC   claim(Guard& guard, const PageKey& key, int& frame, bool& cached);
+  RC   writeBack(int fid, PageId first, PageId last);
+  RC   flushLocked(int fid);
+  int  frameOf(const char* page) const { return (int)((page - data) / pageSize); }
+  char* pageOf(int frame) const { return data + (size_t)frame * pageSize; }
+
+  const int pageSize;
+  char*     data;                   // nFrames * pageSize bytes of page content
+  Frame*    frames;                 // per-frame bookkeeping
+  int       nFrames;                // # of frames
+  std::vector<int> freeFrames;      // frames that currently hold no page
+  std::unordered_map<PageKey, int, PageKeyHash> table; // page -> frame
+  ReplacementPolicy* policy;
+
+  std::unordered_map<int, std::set<PageId> > dirtyPages; // file -> its dirty pages, in order
+  std::unordered_map<int, PageStore*>        stores;     // file -> where to write them
+  std::unordered_map<int, FileCounters>      counters;   // file -> what was done for it
+
+  std::mutex              latch;    // protects everything above but page contents
+  std::condition_variable loaded;   // signalled when a frame finishes loading
+
+  std::atomic<long long> hitCount;       // pins satisfied from the pool
+  std::atomic<long long> missCount;      // pins that had to go to disk
+  std::atomic<long long> evictCount;     // pages dropped to make room for another page
+  std::atomic<long long> writeBackCount; // dirty pages written back
+  std::atomic<long long> prefetchCount;  // pages read by prefetch()
+};
+
+#endif // BUFFERPOOL_H
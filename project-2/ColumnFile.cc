@@ -0,0 +1,623 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/17/2026
+ */
+
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include "ColumnFile.h"
+
+using std::string;
+using std::vector;
+
+//
+// helper functions for the dictionaries of the blocks
+//
+
+// append a length to a string, seven bits per byte, lowest bits first
+static void putLength(string& out, unsigned n);
+
+// read a length stored by putLength. false if the input ends before it
+static bool getLength(const char*& in, const char* end, unsigned& n);
+
+// store the sorted distinct values of a block as a dictionary
+static void encodeDictionary(const vector<string>& dict, string& bytes);
+
+// decode n front-coded values from in. the value before the first one is
+// prev; the last value decoded is left in prev, and each value is added to
+// dict unless it is NULL. false if the input is not valid
+static bool decodeValues(const char* in, const char* end, int n, string& prev, vector<string>* dict);
+
+ColumnFile::ColumnFile()
+{
+  keyFile.reserved = codeFile.reserved = dictFile.reserved = 0;
+  nrows = dend = 0;
+  erid.pid = erid.sid = 0;
+}
+
+bool ColumnFile::exists(const string& table)
+{
+  return ::access((table + ".key").c_str(), F_OK) == 0;
+}
+
+RC ColumnFile::open(const string& table, char mode)
+{
+  RC            rc;
+  PageId        end;
+  KeyPageHeader header;
+  string        bytes;
+  int           length;
+
+  keyFile.reserved = codeFile.reserved = dictFile.reserved = 0;
+  if ((rc = keyFile.pf.open(table + ".key", mode)) < 0) return rc;
+  if ((rc = codeFile.pf.open(table + ".code", mode)) < 0) {
+    keyFile.pf.close();
+    return rc;
+  }
+  if ((rc = dictFile.pf.open(table + ".dict", mode)) < 0) {
+    codeFile.pf.close();
+    keyFile.pf.close();
+    return rc;
+  }
+
+  // the # of records is given by the keys in the last key page
+  nrows = dend = 0;
+  if ((end = keyFile.pf.endPid()) > 0) {
+    if ((rc = readHeader(end - 1, header)) < 0) goto open_failed;
+    if (header.count <= 0 || header.count > KEYS_PER_PAGE) {
+      rc = RC_INVALID_FILE_FORMAT;
+      goto open_failed;
+    }
+    nrows = (long long)(end - 1) * KEYS_PER_PAGE + header.count;
+
+    // the dictionary of the last block is replaced while it is not full
+    dend = header.dict;
+    if (header.count == KEYS_PER_PAGE) {
+      if ((rc = readBytes(header.dict, sizeof(int), bytes)) < 0) goto open_failed;
+      memcpy(&length, bytes.data(), sizeof(int));
+      dend += length;
+    }
+  }
+
+  erid.pid = (PageId)(nrows / KEYS_PER_PAGE);
+  erid.sid = (int)(nrows % KEYS_PER_PAGE);
+  return 0;
+
+  open_failed:
+  close();
+  return rc;
+}
+
+RC ColumnFile::close()
+{
+  RC rc = 0, status;
+
+  nrows = dend = 0;
+  erid.pid = erid.sid = 0;
+  keyFile.reserved = codeFile.reserved = dictFile.reserved = 0;
+
+  // every file is closed even if one of them fails
+  if ((status = keyFile.pf.close()) < 0) rc = status;
+  if ((status = codeFile.pf.close()) < 0 && rc == 0) rc = status;
+  if ((status = dictFile.pf.close()) < 0 && rc == 0) rc = status;
+  return rc;
+}
+
+RC ColumnFile::checkRid(const RecordId& rid) const
+{
+  RecordId end;
+
+  // records may be appended concurrently
+  appendLatch.lock();
+  end = erid;
+  appendLatch.unlock();
+
+  if (rid.pid < 0 || rid.sid < 0 || rid.sid >= KEYS_PER_PAGE) return RC_INVALID_RID;
+  if (rid >= end) return RC_INVALID_RID;
+
+  return 0;
+}
+
+RC ColumnFile::readHeader(PageId pid, KeyPageHeader& header) const
+{
+  RC         rc;
+  PinnedPage page;
+
+  if ((rc = page.pin(keyFile.pf, pid)) < 0) return rc;
+  memcpy(&header, page.data(), sizeof(header));
+  return 0;
+}
+
+RC ColumnFile::read(const RecordId& rid, int& key, string& value) const
+{
+  RC rc;
+
+  if ((rc = readKey(rid, key)) < 0) return rc;
+  return readValue(rid, value);
+}
+
+RC ColumnFile::readKey(const RecordId& rid, int& key) const
+{
+  RC         rc;
+  PinnedPage page;
+
+  if ((rc = checkRid(rid)) < 0) return rc;
+  if ((rc = page.pin(keyFile.pf, rid.pid)) < 0) return rc;
+
+  // the keys follow the header
+  memcpy(&key, page.data() + sizeof(KeyPageHeader) + rid.sid * sizeof(int), sizeof(int));
+  return 0;
+}
+
+RC ColumnFile::readCode(const RecordId& rid, int& code) const
+{
+  RC             rc;
+  PinnedPage     page;
+  unsigned short c;
+
+  if ((rc = checkRid(rid)) < 0) return rc;
+  if ((rc = page.pin(codeFile.pf, rid.pid / BLOCKS_PER_CODE_PAGE)) < 0) return rc;
+
+  memcpy(&c, page.data() + ((rid.pid % BLOCKS_PER_CODE_PAGE) * KEYS_PER_PAGE + rid.sid) * sizeof(c), sizeof(c));
+  code = c;
+  return 0;
+}
+
+RC ColumnFile::readValue(const RecordId& rid, string& value) const
+{
+  string head, bytes;
+
+  return decodeValue(rid, value, head, bytes);
+}
+
+RC ColumnFile::readValue(const RecordId& rid, ValueRef& ref) const
+{
+  RC rc;
+
+  // the buffers of ref are reused from one value to the next
+  ref.clear();
+  if ((rc = decodeValue(rid, ref.copy, ref.scratch[0], ref.scratch[1])) < 0) return rc;
+  ref.value.data = ref.copy.data();
+  ref.value.length = (int)ref.copy.size();
+  return 0;
+}
+
+RC ColumnFile::decodeValue(const RecordId& rid, string& value, string& head, string& bytes) const
+{
+  RC            rc;
+  KeyPageHeader header;
+  int           code, restarts, start, end, length;
+
+  if ((rc = readCode(rid, code)) < 0) return rc;
+  if ((rc = readHeader(rid.pid, header)) < 0) return rc;
+  if (code >= header.entries) return RC_INVALID_FILE_FORMAT;
+
+  // the value is decoded from the last value before it that is stored whole
+  restarts = (header.entries + RESTART_INTERVAL - 1) / RESTART_INTERVAL;
+  if ((rc = readBytes(header.dict, (1 + restarts) * sizeof(int), head)) < 0) return rc;
+  memcpy(&length, head.data(), sizeof(int));
+  memcpy(&start, head.data() + (1 + code / RESTART_INTERVAL) * sizeof(int), sizeof(int));
+  end = length;
+  if (code / RESTART_INTERVAL + 1 < restarts) {
+    memcpy(&end, head.data() + (2 + code / RESTART_INTERVAL) * sizeof(int), sizeof(int));
+  }
+  if (start < (int)head.size() || start > end || end > length) return RC_INVALID_FILE_FORMAT;
+
+  if ((rc = readBytes(header.dict + start, end - start, bytes)) < 0) return rc;
+
+  value.clear();
+  if (!decodeValues(bytes.data(), bytes.data() + bytes.size(), code % RESTART_INTERVAL + 1, value, NULL)) {
+    return RC_INVALID_FILE_FORMAT;
+  }
+  return 0;
+}
+
+RC ColumnFile::readDictionary(PageId pid, vector<string>& dict) const
+{
+  RC            rc;
+  KeyPageHeader header;
+  string        bytes, prev;
+  int           restarts, length;
+
+  dict.clear();
+  if (pid < 0 || pid >= keyFile.pf.endPid()) return RC_INVALID_PID;
+  if ((rc = readHeader(pid, header)) < 0) return rc;
+
+  if ((rc = readBytes(header.dict, sizeof(int), bytes)) < 0) return rc;
+  memcpy(&length, bytes.data(), sizeof(int));
+  if ((rc = readBytes(header.dict, length, bytes)) < 0) return rc;
+
+  restarts = (header.entries + RESTART_INTERVAL - 1) / RESTART_INTERVAL;
+  if ((int)((1 + restarts) * sizeof(int)) > length) return RC_INVALID_FILE_FORMAT;
+
+  dict.reserve(header.entries);
+  if (!decodeValues(bytes.data() + (1 + restarts) * sizeof(int), bytes.data() + length, header.entries, prev, &dict)) {
+    dict.clear();
+    return RC_INVALID_FILE_FORMAT;
+  }
+  return 0;
+}
+
+RC ColumnFile::readBytes(long long offset, int n, string& bytes) const
+{
+  RC         rc;
+  PinnedPage page;
+
+  // copy the bytes from each dictionary page they span
+  bytes.clear();
+  bytes.reserve(n);
+  for (long long pos = offset; pos < offset + n; ) {
+    int start = (int)(pos % PageFile::PAGE_SIZE);
+    int m = (int)std::min(offset + n - pos, (long long)(PageFile::PAGE_SIZE - start));
+
+    if ((rc = page.pin(dictFile.pf, (PageId)(pos / PageFile::PAGE_SIZE))) < 0) return rc;
+    bytes.append(page.data() + start, m);
+    pos += m;
+  }
+
+  return 0;
+}
+
+RC ColumnFile::writeBytes(long long offset, const string& bytes)
+{
+  RC   rc;
+  char page[PageFile::PAGE_SIZE];
+
+  // the bytes go at the end of the stream, where nothing follows them
+  for (size_t done = 0; done < bytes.size(); ) {
+    long long pos = offset + done;
+    PageId    pid = (PageId)(pos / PageFile::PAGE_SIZE);
+    int       start = (int)(pos % PageFile::PAGE_SIZE);
+    int       m = (int)std::min(bytes.size() - done, (size_t)(PageFile::PAGE_SIZE - start));
+
+    if ((rc = loadPage(dictFile, pid, start != 0, page)) < 0) return rc;
+    memcpy(page + start, bytes.data() + done, m);
+    if ((rc = writePage(dictFile, pid, page)) < 0) return rc;
+    done += m;
+  }
+
+  return 0;
+}
+
+RC ColumnFile::append(int key, const string& value, RecordId& rid)
+{
+  std::lock_guard<std::mutex> guard(appendLatch);
+
+  return appendRecords(&key, &value, 1, &rid);
+}
+
+RC ColumnFile::appendBatch(const vector<int>& keys, const vector<string>& values, vector<RecordId>& rids)
+{
+  std::lock_guard<std::mutex> guard(appendLatch);
+
+  if (keys.size() != values.size()) return RC_INVALID_ATTRIBUTE;
+
+  rids.resize(keys.size());
+  if (keys.empty()) return 0;
+
+  return appendRecords(&keys[0], &values[0], (int)keys.size(), &rids[0]);
+}
+
+RC ColumnFile::appendRecords(const int* keys, const string* values, int n, RecordId* rids)
+{
+  RC             rc;
+  char           keyPage[PageFile::PAGE_SIZE];
+  vector<string> block; // the values of the records of the last block
+
+  if (n == 0) return 0;
+
+  // the last block may be partly filled
+  if (nrows % KEYS_PER_PAGE != 0) {
+    if ((rc = keyFile.pf.read((PageId)(nrows / KEYS_PER_PAGE), keyPage)) < 0) return rc;
+    if ((rc = loadBlock((PageId)(nrows / KEYS_PER_PAGE), block)) < 0) return rc;
+  }
+
+  // a block is written as soon as it is full
+  for (int i = 0; i < n; i++) {
+    PageId pid = (PageId)(nrows / KEYS_PER_PAGE);
+    int    sid = (int)(nrows % KEYS_PER_PAGE);
+
+    if (sid == 0) {
+      memset(keyPage, 0, PageFile::PAGE_SIZE);
+      block.clear();
+    }
+    memcpy(keyPage + sizeof(KeyPageHeader) + sid * sizeof(int), &keys[i], sizeof(int));
+    block.push_back(values[i]);
+
+    rids[i].pid = pid;
+    rids[i].sid = sid;
+    nrows++;
+
+    if (sid == KEYS_PER_PAGE - 1 && (rc = writeBlock(pid, keyPage, block)) < 0) return rc;
+  }
+
+  // write the partly filled last block
+  if (nrows % KEYS_PER_PAGE != 0 &&
+      (rc = writeBlock((PageId)(nrows / KEYS_PER_PAGE), keyPage, block)) < 0) return rc;
+
+  erid.pid = (PageId)(nrows / KEYS_PER_PAGE);
+  erid.sid = (int)(nrows % KEYS_PER_PAGE);
+  return 0;
+}
+
+RC ColumnFile::loadBlock(PageId pid, vector<string>& values) const
+{
+  RC             rc;
+  PinnedPage     page;
+  KeyPageHeader  header;
+  vector<string> dict;
+  unsigned short code;
+
+  values.clear();
+  if ((rc = readHeader(pid, header)) < 0) return rc;
+  if ((rc = readDictionary(pid, dict)) < 0) return rc;
+  if ((rc = page.pin(codeFile.pf, pid / BLOCKS_PER_CODE_PAGE)) < 0) return rc;
+
+  for (int sid = 0; sid < header.count; sid++) {
+    memcpy(&code, page.data() + ((pid % BLOCKS_PER_CODE_PAGE) * KEYS_PER_PAGE + sid) * sizeof(code), sizeof(code));
+    if (code >= dict.size()) return RC_INVALID_FILE_FORMAT;
+    values.push_back(dict[code]);
+  }
+
+  return 0;
+}
+
+RC ColumnFile::writeBlock(PageId pid, char* keyPage, const vector<string>& values)
+{
+  RC             rc;
+  char           codePage[PageFile::PAGE_SIZE];
+  PageId         cpid = pid / BLOCKS_PER_CODE_PAGE;
+  vector<string> dict(values);
+  string         bytes;
+  KeyPageHeader  header;
+
+  // the dictionary of the block: its distinct values in order
+  std::sort(dict.begin(), dict.end());
+  dict.erase(std::unique(dict.begin(), dict.end()), dict.end());
+  encodeDictionary(dict, bytes);
+
+  // the dictionary is written first, then the codes, then the keys,
+  // whose page tells how many records the block has
+  if ((rc = writeBytes(dend, bytes)) < 0) return rc;
+
+  // the blocks before this one in the code page are kept
+  if ((rc = loadPage(codeFile, cpid, pid % BLOCKS_PER_CODE_PAGE != 0, codePage)) < 0) return rc;
+  for (unsigned sid = 0; sid < values.size(); sid++) {
+    unsigned short code = (unsigned short)(std::lower_bound(dict.begin(), dict.end(), values[sid]) - dict.begin());
+    memcpy(codePage + ((pid % BLOCKS_PER_CODE_PAGE) * KEYS_PER_PAGE + sid) * sizeof(code), &code, sizeof(code));
+  }
+  if ((rc = writePage(codeFile, cpid, codePage)) < 0) return rc;
+
+  header.count = (int)values.size();
+  header.entries = (int)dict.size();
+  header.dict = dend;
+  memcpy(keyPage, &header, sizeof(header));
+  if ((rc = writePage(keyFile, pid, keyPage)) < 0) return rc;
+
+  // the next block starts a new dictionary once this one is full
+  if (header.count == KEYS_PER_PAGE) dend += bytes.size();
+  return 0;
+}
+
+RC ColumnFile::loadPage(const Column& column, PageId pid, bool used, char* page) const
+{
+  if (!used) {
+    memset(page, 0, PageFile::PAGE_SIZE);
+    return 0;
+  }
+  return column.pf.read(pid, page);
+}
+
+RC ColumnFile::writePage(Column& column, PageId pid, const char* page)
+{
+  RC rc;
+
+  // reserve disk space for a whole extent of pages at a time,
+  // so that the file does not grow one page at a time
+  if (pid >= column.reserved) {
+    if ((rc = column.pf.reserve(pid, PageFile::EXTENT_PAGES)) < 0) return rc;
+    column.reserved = pid + PageFile::EXTENT_PAGES;
+  }
+
+  return column.pf.write(pid, page);
+}
+
+const RecordId& ColumnFile::endRid() const
+{
+  return erid;
+}
+
+RC ColumnFile::seek(RecordId& rid) const
+{
+  RecordId end;
+
+  // records may be appended concurrently
+  appendLatch.lock();
+  end = erid;
+  appendLatch.unlock();
+
+  // every key page but the last one is full
+  if (rid.sid >= KEYS_PER_PAGE) {
+    rid.pid++;
+    rid.sid = 0;
+  }
+
+  return (rid < end) ? 0 : RC_NO_SUCH_RECORD;
+}
+
+RC ColumnFile::next(RecordId& rid) const
+{
+  rid.sid++;
+  return seek(rid);
+}
+
+RC ColumnFile::nextBatch(RecordId& rid, ScanBatch& batch) const
+{
+  RC            rc;
+  KeyPageHeader header;
+
+  batch.clear();
+  if ((rc = seek(rid)) < 0) return rc;
+
+  if ((rc = batch.page.pin(keyFile.pf, rid.pid)) < 0) return rc;
+  memcpy(&header, batch.page.data(), sizeof(header));
+  batch.pid = rid.pid;
+  batch.first = rid.sid;
+  batch.count = header.count - rid.sid;
+  if (batch.count <= 0) return RC_INVALID_FILE_FORMAT;
+
+  // the keys of a block are stored next to each other
+  batch.keys.resize(batch.count);
+  memcpy(&batch.keys[0], batch.page.data() + sizeof(KeyPageHeader) + rid.sid * sizeof(int), batch.count * sizeof(int));
+  batch.page.release();
+
+  rid.pid++;
+  rid.sid = 0;
+  return 0;
+}
+
+RC ColumnFile::readValues(ScanBatch& batch) const
+{
+  RC             rc;
+  PinnedPage     page;
+  unsigned short code;
+
+  if ((rc = readDictionary(batch.pid, batch.dict)) < 0) return rc;
+  if ((rc = page.pin(codeFile.pf, batch.pid / BLOCKS_PER_CODE_PAGE)) < 0) return rc;
+
+  // the values point into the dictionary
+  batch.codes.resize(batch.count);
+  batch.values.resize(batch.count);
+  for (int i = 0; i < batch.count; i++) {
+    memcpy(&code, page.data() + ((batch.pid % BLOCKS_PER_CODE_PAGE) * KEYS_PER_PAGE + batch.first + i) * sizeof(code), sizeof(code));
+    if (code >= batch.dict.size()) return RC_INVALID_FILE_FORMAT;
+
+    batch.codes[i] = code;
+    batch.values[i].data = batch.dict[code].data();
+    batch.values[i].length = (int)batch.dict[code].size();
+  }
+
+  return 0;
+}
+
+RC ColumnFile::prefetch(const vector<RecordId>& rids) const
+{
+  vector<PageId> keyPids, codePids;
+  RC rc;
+
+  // records of the same page are usually next to each other.
+  // the dictionary pages are only known once the key pages are read
+  for (unsigned i = 0; i < rids.size(); i++) {
+    PageId cpid = rids[i].pid / BLOCKS_PER_CODE_PAGE;
+
+    if (keyPids.empty() || keyPids.back() != rids[i].pid) keyPids.push_back(rids[i].pid);
+    if (codePids.empty() || codePids.back() != cpid) codePids.push_back(cpid);
+  }
+
+  if ((rc = keyFile.pf.prefetch(keyPids)) < 0) return rc;
+  return codeFile.pf.prefetch(codePids);
+}
+
+RC ColumnFile::prewarm(int maxPages, int& count) const
+{
+  RC  rc;
+  int n;
+
+  count = 0;
+  if ((rc = prewarmFile(keyFile.pf, maxPages, n)) < 0) return rc;
+  count += n;
+  if ((rc = prewarmFile(codeFile.pf, maxPages - count, n)) < 0) return rc;
+  count += n;
+  if ((rc = prewarmFile(dictFile.pf, maxPages - count, n)) < 0) return rc;
+  count += n;
+
+  return 0;
+}
+
+RC ColumnFile::prewarmFile(const PageFile& pf, int maxPages, int& count) const
+{
+  vector<PageId> pids;
+  PageId end = pf.endPid();
+
+  for (PageId pid = 0; pid < end && (int)pids.size() < maxPages; pid++) pids.push_back(pid);
+  count = (int)pids.size();
+
+  return pids.empty() ? 0 : pf.prewarm(pids);
+}
+
+RC ColumnFile::setAccessPattern(PageFile::AccessPattern pattern)
+{
+  RC rc;
+
+  if ((rc = keyFile.pf.setAccessPattern(pattern)) < 0) return rc;
+  if ((rc = codeFile.pf.setAccessPattern(pattern)) < 0) return rc;
+  return dictFile.pf.setAccessPattern(pattern);
+}
+
+static void putLength(string& out, unsigned n)
+{
+  while (n >= 0x80) {
+    out.push_back((char)(n | 0x80));
+    n >>= 7;
+  }
+  out.push_back((char)n);
+}
+
+static bool getLength(const char*& in, const char* end, unsigned& n)
+{
+  n = 0;
+  for (int shift = 0; in < end && shift < 32; shift += 7) {
+    unsigned char c = *in++;
+    n |= (unsigned)(c & 0x7f) << shift;
+    if (!(c & 0x80)) return true;
+  }
+  return false;
+}
+
+static void encodeDictionary(const vector<string>& dict, string& bytes)
+{
+  int restarts = (int)((dict.size() + ColumnFile::RESTART_INTERVAL - 1) / ColumnFile::RESTART_INTERVAL);
+  int length;
+
+  // the length and the offsets of the values stored whole come first
+  bytes.assign((1 + restarts) * sizeof(int), 0);
+
+  for (unsigned i = 0; i < dict.size(); i++) {
+    unsigned prefix = 0;
+
+    if (i % ColumnFile::RESTART_INTERVAL == 0) {
+      int offset = (int)bytes.size();
+      memcpy(&bytes[(1 + i / ColumnFile::RESTART_INTERVAL) * sizeof(int)], &offset, sizeof(int));
+    } else {
+      const string& prev = dict[i - 1];
+      while (prefix < prev.size() && prefix < dict[i].size() && prev[prefix] == dict[i][prefix]) prefix++;
+    }
+
+    putLength(bytes, prefix);
+    putLength(bytes, (unsigned)dict[i].size() - prefix);
+    bytes.append(dict[i], prefix, string::npos);
+  }
+
+  length = (int)bytes.size();
+  memcpy(&bytes[0], &length, sizeof(int));
+}
+
+static bool decodeValues(const char* in, const char* end, int n, string& prev, vector<string>* dict)
+{
+  unsigned prefix, suffix;
+
+  for (int i = 0; i < n; i++) {
+    if (!getLength(in, end, prefix) || !getLength(in, end, suffix)) return false;
+    if (prefix > prev.size() || suffix > (unsigned)(end - in)) return false;
+
+    prev.erase(prefix);
+    prev.append(in, suffix);
+    in += suffix;
+    if (dict != NULL) dict->push_back(prev);
+  }
+
+  return true;
+}
@@ -0,0 +1,249 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/17/2026
+ */
+
+#ifndef COLUMNFILE_H
+#define COLUMNFILE_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include "Bruinbase.h"
+#include "PageFile.h"
+#include "TableFile.h"
+
+/**
+ * read/write the records of a table stored by columns.
+ * records may be read and appended from several threads at once;
+ * appends are serialized.
+ *
+ * the records are grouped into blocks of KEYS_PER_PAGE records, and a
+ * table is kept in three page files:
+ *  - table.key holds the keys, one page per block. a key page starts with
+ *    the # of keys in it, the # of entries of the dictionary of the block
+ *    and where the dictionary starts in table.dict, followed by the keys,
+ *    so that a scan of the keys reads about 1/25th of the bytes of the rows
+ *    of a version 2 table.
+ *  - table.dict holds the dictionaries of the blocks, one after the other
+ *    in a single stream of bytes that runs across its pages. the dictionary
+ *    of a block is the distinct values of its records in sorted order,
+ *    each stored as the length of the prefix it shares with the value
+ *    before it, followed by the rest of the value (front coding). every
+ *    RESTART_INTERVAL'th value is stored whole, and the dictionary starts
+ *    with its length and the offsets of these values, so that a single
+ *    value is decoded without the values before it.
+ *  - table.code holds, for every record, the index of its value in the
+ *    dictionary of its block (its code), in two bytes. codes follow the
+ *    order of the values, so that a comparison of two values of a block
+ *    is a comparison of their codes.
+ *
+ * the record with id (pid, sid) is the sid'th record of block pid. values
+ * are only read when they are asked for, so that a scan can check the key
+ * of every record and decode the values of just those that qualify.
+ */
+class ColumnFile : public TableFile {
+ public:
+
+  // # of keys per page of the key file, and of records per block
+  static const int KEYS_PER_PAGE = (PageFile::PAGE_SIZE - 2 * sizeof(int) - sizeof(long long)) / sizeof(int);
+
+  // # of blocks whose codes are stored in a page of the code file
+  static const int BLOCKS_PER_CODE_PAGE = PageFile::PAGE_SIZE / (KEYS_PER_PAGE * sizeof(unsigned short));
+
+  // a value of a dictionary out of this many is stored whole
+  static const int RESTART_INTERVAL = 16;
+
+  ColumnFile();
+
+  /**
+   * open the files of a table in read or write mode.
+   * when opened in 'w' mode, the files that do not exist are created.
+   * @param table[IN] the name of the table; the files are named after it
+   * @param mode[IN] 'r' for read, 'w' for write
+   * @return error code. 0 if no error
+   */
+  RC open(const std::string& table, char mode);
+
+  /**
+   * @param table[IN] the name of a table
+   * @return true if the table is stored by columns
+   */
+  static bool exists(const std::string& table);
+
+  /**
+   * close the files of the table.
+   * @return error code. 0 if no error
+   */
+  RC close();
+
+  /**
+   * read a record from the table.
+   * @param rid[IN] the id of the record to read
+   * @param key[OUT] the record key
+   * @param value[OUT] the record value
+   * @return error code. 0 if no error
+   */
+  RC read(const RecordId& rid, int& key, std::string& value) const;
+
+  /**
+   * read only the key of a record: a single page of the key file.
+   * @param rid[IN] the id of the record to read
+   * @param key[OUT] the record key
+   * @return error code. 0 if no error
+   */
+  RC readKey(const RecordId& rid, int& key) const;
+
+  /**
+   * read only the value of a record from the code and dictionary files.
+   * @param rid[IN] the id of the record to read
+   * @param value[OUT] the record value
+   * @return error code. 0 if no error
+   */
+  RC readValue(const RecordId& rid, std::string& value) const;
+
+  /**
+   * read only the value of a record. the value is decoded from the
+   * dictionary of its block into ref.
+   * @param rid[IN] the id of the record to read
+   * @param ref[OUT] the record value, valid until ref is cleared or reused
+   * @return error code. 0 if no error
+   */
+  RC readValue(const RecordId& rid, ValueRef& ref) const;
+
+  /**
+   * read the code of the value of a record: its index in the dictionary
+   * of the block of the record (see readDictionary()).
+   * @param rid[IN] the id of the record
+   * @param code[OUT] the code of the record value
+   * @return error code. 0 if no error
+   */
+  RC readCode(const RecordId& rid, int& code) const;
+
+  /**
+   * read the dictionary of a block: the distinct values of its records, in
+   * sorted order. the value of a record of the block is dict[code].
+   * @param pid[IN] the block, i.e., the pid of the ids of its records
+   * @param dict[OUT] the values of the block
+   * @return error code. 0 if no error
+   */
+  RC readDictionary(PageId pid, std::vector<std::string>& dict) const;
+
+  /**
+   * append a new record at the end of the table.
+   * @param key[IN] the record key
+   * @param value[IN] the record value
+   * @param rid[OUT] the location of the stored record
+   * @return error code. 0 if no error
+   */
+  RC append(int key, const std::string& value, RecordId& rid);
+
+  /**
+   * append a batch of records at the end of the table. a block is encoded
+   * in memory and written once it is full; the last block of the table,
+   * which is not full, is encoded again whenever records are added to it.
+   * @param keys[IN] the record keys
+   * @param values[IN] the record values, one for each key
+   * @param rids[OUT] the location of each stored record
+   * @return error code. 0 if no error
+   */
+  RC appendBatch(const std::vector<int>& keys, const std::vector<std::string>& values, std::vector<RecordId>& rids);
+
+  /**
+   * note the +1 part. The rid of the last record is endRid()-1.
+   * @return (last record id + 1) of the table
+   */
+  const RecordId& endRid() const;
+
+  /**
+   * move a record id forward to the first record at or after it.
+   * @param rid[IN/OUT] the record id to move, e.g., (0, 0) to find the first record
+   * @return error code. RC_NO_SUCH_RECORD if no record is left
+   */
+  RC seek(RecordId& rid) const;
+
+  /**
+   * move a record id to the next record of the table.
+   * @param rid[IN/OUT] the id of a record
+   * @return error code. RC_NO_SUCH_RECORD if it was the last record
+   */
+  RC next(RecordId& rid) const;
+
+  /**
+   * read the keys of the records of a block in one go, starting at the
+   * first record at or after a record id.
+   * @param rid[IN/OUT] where the scan is; moved to the first record of the next block
+   * @param batch[OUT] the records read
+   * @return error code. RC_NO_SUCH_RECORD if no record is left
+   */
+  RC nextBatch(RecordId& rid, ScanBatch& batch) const;
+
+  /**
+   * read the values of the records of a batch read by nextBatch(): their
+   * codes, and the dictionary of the block the values point into.
+   * @param batch[IN/OUT] the batch
+   * @return error code. 0 if no error
+   */
+  RC readValues(ScanBatch& batch) const;
+
+  /**
+   * read the key and code pages of a set of records into the page cache.
+   * @param rids[IN] the records that are going to be read
+   * @return error code. 0 if no error
+   */
+  RC prefetch(const std::vector<RecordId>& rids) const;
+
+  /**
+   * read the first pages of the table into the page cache: the keys
+   * first, then the codes and the dictionaries.
+   * @param maxPages[IN] the most pages to read
+   * @param count[OUT] the # of pages read
+   * @return error code. 0 if no error
+   */
+  RC prewarm(int maxPages, int& count) const;
+
+  /**
+   * tell the kernel in which order the records are going to be read.
+   * @param pattern[IN] the expected access pattern
+   * @return error code. 0 if no error
+   */
+  RC setAccessPattern(PageFile::AccessPattern pattern);
+
+ private:
+  // a file of the table and the end of the disk space reserved for appends
+  struct Column {
+    PageFile pf;
+    PageId   reserved;
+  };
+
+  // the start of a key page
+  struct KeyPageHeader {
+    int       count;   // # of keys in the page
+    int       entries; // # of values in the dictionary of the block
+    long long dict;    // where the dictionary starts in the dictionary file
+  };
+
+  RC checkRid(const RecordId& rid) const;
+  RC readHeader(PageId pid, KeyPageHeader& header) const;
+  RC readBytes(long long offset, int n, std::string& bytes) const;
+  RC decodeValue(const RecordId& rid, std::string& value, std::string& head, std::string& bytes) const;
+  RC writeBytes(long long offset, const std::string& bytes);
+  RC loadBlock(PageId pid, std::vector<std::string>& values) const;
+  RC writeBlock(PageId pid, char* keyPage, const std::vector<std::string>& values);
+  RC appendRecords(const int* keys, const std::string* values, int n, RecordId* rids);
+  RC loadPage(const Column& column, PageId pid, bool used, char* page) const;
+  RC writePage(Column& column, PageId pid, const char* page);
+  RC prewarmFile(const PageFile& pf, int maxPages, int& count) const;
+
+  Column    keyFile;   // the key file
+  Column    codeFile;  // the code file
+  Column    dictFile;  // the dictionary file
+  long long nrows;     // # of records in the table
+  long long dend;      // where the dictionary of the last block starts, or of the next block if it is full
+  RecordId  erid;      // the last record id of the table + 1
+  mutable std::mutex appendLatch; // protects nrows, dend, erid and the last block
+};
+
+#endif // COLUMNFILE_H
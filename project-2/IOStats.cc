@@ -0,0 +1,94 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/17/2026
+ */
+
+#include <map>
+#include <mutex>
+#include "IOStats.h"
+
+LatencyHistogram::LatencyHistogram()
+: total(0)
+{
+  for (int i = 0; i < BUCKETS; i++) buckets[i] = 0;
+}
+
+void LatencyHistogram::record(long long nanos)
+{
+  unsigned long long micros = (nanos > 0) ? (unsigned long long)nanos / 1000 : 0;
+
+  // the bucket is the number of significant bits of the latency in us
+  int b = (micros == 0) ? 0 : 64 - __builtin_clzll(micros);
+  if (b >= BUCKETS) b = BUCKETS - 1;
+
+  buckets[b]++;
+  total += nanos;
+}
+
+long long LatencyHistogram::count() const
+{
+  long long n = 0;
+  for (int i = 0; i < BUCKETS; i++) n += buckets[i];
+  return n;
+}
+
+long long LatencyHistogram::percentile(double fraction) const
+{
+  long long n = count();
+  long long seen = 0;
+
+  if (n == 0) return 0;
+
+  // the upper bound of the bucket holding the requested rank
+  for (int i = 0; i < BUCKETS; i++) {
+    seen += buckets[i];
+    if (seen >= fraction * n) return 1LL << i;
+  }
+
+  return 1LL << (BUCKETS - 1);
+}
+
+FileStats::FileStats()
+: reads(0), writes(0), bytesRead(0), bytesWritten(0)
+{
+}
+
+// the counters of every file, by page cache id
+static std::map<int, FileStats*>& registry()
+{
+  static std::map<int, FileStats*> files;
+  return files;
+}
+
+static std::mutex registryLatch;
+
+FileStats* FileStats::get(int fid, const std::string& name)
+{
+  std::lock_guard<std::mutex> guard(registryLatch);
+  std::map<int, FileStats*>& files = registry();
+
+  std::map<int, FileStats*>::iterator it = files.find(fid);
+  if (it != files.end()) return it->second;
+
+  FileStats* stats = new FileStats;
+  stats->name = name;
+  files[fid] = stats;
+  return stats;
+}
+
+void FileStats::list(std::vector<int>& fids, std::vector<const FileStats*>& files)
+{
+  std::lock_guard<std::mutex> guard(registryLatch);
+  std::map<int, FileStats*>& all = registry();
+
+  fids.clear();
+  files.clear();
+
+  // page cache ids are handed out in the order files are first opened
+  for (std::map<int, FileStats*>::iterator it = all.begin(); it != all.end(); ++it) {
+    fids.push_back(it->first);
+    files.push_back(it->second);
+  }
+}
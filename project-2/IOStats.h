@@ -0,0 +1,123 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/17/2026
+ */
+
+#ifndef IOSTATS_H
+#define IOSTATS_H
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <time.h>
+
+/**
+ * A histogram of I/O latencies with power-of-two buckets:
+ * bucket 0 counts latencies below 1us, bucket i latencies in [2^(i-1), 2^i) us.
+ * Recording is lock-free.
+ */
+class LatencyHistogram {
+ public:
+  static const int BUCKETS = 32;
+
+  LatencyHistogram();
+
+  /**
+   * count one operation.
+   * @param nanos[IN] how long the operation took in nanoseconds
+   */
+  void record(long long nanos);
+
+  /**
+   * @return the # of operations recorded
+   */
+  long long count() const;
+
+  /**
+   * @param fraction[IN] e.g., 0.99 for the 99th percentile
+   * @return an upper bound of the latency percentile in microseconds,
+   *   or 0 if nothing was recorded
+   */
+  long long percentile(double fraction) const;
+
+  /**
+   * @return the total time of the recorded operations in nanoseconds
+   */
+  long long totalNanos() const { return total; }
+
+ private:
+  std::atomic<long long> buckets[BUCKETS];
+  std::atomic<long long> total;
+};
+
+/**
+ * The I/O counters of one file. Files are told apart by their page
+ * cache id (see PageFile), so the counters of a file survive closing
+ * and reopening it. The objects live as long as the program.
+ */
+class FileStats {
+ public:
+  std::string name;                     // the name the file was first opened with
+
+  std::atomic<long long> reads;         // # of pages read from disk
+  std::atomic<long long> writes;        // # of pages written to disk
+  std::atomic<long long> bytesRead;     // # of bytes read from disk
+  std::atomic<long long> bytesWritten;  // # of bytes written to disk
+  LatencyHistogram readLatency;         // per read system call (or batch)
+  LatencyHistogram writeLatency;        // per write system call
+
+  /**
+   * count one read.
+   * @param pages[IN] the # of pages read
+   * @param bytes[IN] the # of bytes read
+   * @param start[IN] the time the read started (see now())
+   */
+  void recordRead(int pages, long long bytes, long long start) {
+    reads += pages;
+    bytesRead += bytes;
+    readLatency.record(now() - start);
+  }
+
+  /**
+   * count one write.
+   * @param pages[IN] the # of pages written
+   * @param bytes[IN] the # of bytes written
+   * @param start[IN] the time the write started (see now())
+   */
+  void recordWrite(int pages, long long bytes, long long start) {
+    writes += pages;
+    bytesWritten += bytes;
+    writeLatency.record(now() - start);
+  }
+
+  /**
+   * @return a monotonic time in nanoseconds
+   */
+  static long long now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+  }
+
+  /**
+   * get the counters of a file, creating them on first use.
+   * @param fid[IN] the page cache id of the file
+   * @param name[IN] the name of the file
+   * @return the counters; never NULL
+   */
+  static FileStats* get(int fid, const std::string& name);
+
+  /**
+   * list the files with counters, in the order they were first opened.
+   * @param fids[OUT] the page cache id of each file
+   * @param files[OUT] the counters of each file
+   */
+  static void list(std::vector<int>& fids, std::vector<const FileStats*>& files);
+
+ private:
+  FileStats();
+};
+
+#endif // IOSTATS_H
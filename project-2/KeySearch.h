@@ -0,0 +1,186 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/17/2026
+ */
+
+#ifndef KEYSEARCH_H
+#define KEYSEARCH_H
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/**
+ * the ways BTRawNode searches the sorted keys of a node, chosen at compile
+ * time by its Search template parameter. each one provides
+ *  - lowerBound(keys, count, key): the index of the first of the count
+ *    keys that is not less than key, or count if there is none,
+ *  - upperBound(keys, count, key): the index of the first of the count
+ *    keys that is larger than key, or count if there is none.
+ */
+
+/**
+ * compares the keys one after the other from the first.
+ */
+struct LinearKeySearch {
+  template <typename Key>
+  static unsigned lowerBound(const Key* keys, unsigned count, const Key& key) {
+    unsigned eid = 0;
+
+    while(eid < count && keys[eid] < key)
+      eid++;
+
+    return eid;
+  }
+
+  template <typename Key>
+  static unsigned upperBound(const Key* keys, unsigned count, const Key& key) {
+    unsigned eid = 0;
+
+    while(eid < count && keys[eid] <= key)
+      eid++;
+
+    return eid;
+  }
+};
+
+/**
+ * halves the keys left to search at every step, picking the half with a
+ * conditional move rather than a branch, so that the steps are the same
+ * for every key and never mispredicted.
+ */
+struct BinaryKeySearch {
+  /**
+   * narrow the search down to at most n keys starting at base. the index
+   * sought is then base plus the # of those keys that are less than key
+   * (lowerBound), or not larger than it (upperBound).
+   */
+  template <typename Key, bool upper>
+  static void narrow(const Key*& base, unsigned& n, const Key& key, unsigned limit) {
+    while(n > limit) {
+      const unsigned half = n / 2;
+
+      base = (upper ? base[half] <= key : base[half] < key) ? base + half : base;
+      n -= half;
+    }
+  }
+
+  template <typename Key>
+  static unsigned lowerBound(const Key* keys, unsigned count, const Key& key) {
+    const Key* base = keys;
+    unsigned   n = count;
+
+    if(n == 0)
+      return 0;
+
+    narrow<Key, false>(base, n, key, 1);
+    return (unsigned)(base - keys) + (*base < key);
+  }
+
+  template <typename Key>
+  static unsigned upperBound(const Key* keys, unsigned count, const Key& key) {
+    const Key* base = keys;
+    unsigned   n = count;
+
+    if(n == 0)
+      return 0;
+
+    narrow<Key, true>(base, n, key, 1);
+    return (unsigned)(base - keys) + (*base <= key);
+  }
+};
+
+/**
+ * narrows the search down to BLOCK keys like BinaryKeySearch, then
+ * compares the key with all of them at once, LANES keys to a vector
+ * instruction: AVX2 if the build targets it (e.g., make SIMD=-mavx2), SSE2
+ * otherwise. the block always holds BLOCK keys of the node, so that the
+ * last steps of the binary search, which wait on each other, become a few
+ * independent vector compares with no loop left to mispredict. nodes with
+ * fewer keys, keys other than int and builds for other processors fall
+ * back on BinaryKeySearch.
+ */
+struct SimdKeySearch {
+#if defined(__AVX2__)
+  static const unsigned LANES = 8;
+#else
+  static const unsigned LANES = 4;
+#endif
+
+  static const unsigned BLOCK = 2 * LANES;
+
+  template <typename Key>
+  static unsigned lowerBound(const Key* keys, unsigned count, const Key& key) {
+    return BinaryKeySearch::lowerBound(keys, count, key);
+  }
+
+  template <typename Key>
+  static unsigned upperBound(const Key* keys, unsigned count, const Key& key) {
+    return BinaryKeySearch::upperBound(keys, count, key);
+  }
+
+#if defined(__AVX2__) || defined(__SSE2__)
+  static unsigned lowerBound(const int* keys, unsigned count, const int& key) {
+    const int* base = keys;
+    unsigned   n = count;
+
+    if(count < BLOCK)
+      return BinaryKeySearch::lowerBound(keys, count, key);
+
+    // the keys before the block are less than key, those after it are not
+    BinaryKeySearch::narrow<int, false>(base, n, key, BLOCK);
+    base = (base < keys + count - BLOCK) ? base : keys + count - BLOCK;
+    return (unsigned)(base - keys) + countBlock(base, key, false);
+  }
+
+  static unsigned upperBound(const int* keys, unsigned count, const int& key) {
+    const int* base = keys;
+    unsigned   n = count;
+
+    if(count < BLOCK)
+      return BinaryKeySearch::upperBound(keys, count, key);
+
+    BinaryKeySearch::narrow<int, true>(base, n, key, BLOCK);
+    base = (base < keys + count - BLOCK) ? base : keys + count - BLOCK;
+    return (unsigned)(base - keys) + BLOCK - countBlock(base, key, true);
+  }
+
+  /**
+   * @param block[IN] BLOCK keys
+   * @param key[IN] the key to compare them with
+   * @param greater[IN] whether to count the keys larger than key, or those less than it
+   * @return the # of keys of the block larger (or less) than key
+   */
+  static unsigned countBlock(const int* block, int key, bool greater) {
+#if defined(__AVX2__)
+    const __m256i k = _mm256_set1_epi32(key);
+    __m256i       sum = _mm256_setzero_si256();
+
+    // a lane of a comparison is -1 where it holds
+    for(unsigned i = 0; i < BLOCK; i += LANES) {
+      const __m256i v = _mm256_loadu_si256((const __m256i*)(block + i));
+      sum = _mm256_sub_epi32(sum, greater ? _mm256_cmpgt_epi32(v, k) : _mm256_cmpgt_epi32(k, v));
+    }
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+#else
+    const __m128i k = _mm_set1_epi32(key);
+    __m128i       half = _mm_setzero_si128();
+
+    for(unsigned i = 0; i < BLOCK; i += LANES) {
+      const __m128i v = _mm_loadu_si128((const __m128i*)(block + i));
+      half = _mm_sub_epi32(half, greater ? _mm_cmpgt_epi32(v, k) : _mm_cmpgt_epi32(k, v));
+    }
+#endif
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4e));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xb1));
+    return (unsigned)_mm_cvtsi128_si32(half);
+  }
+#endif
+};
+
+// the search of the nodes of the B+tree
+typedef SimdKeySearch DefaultKeySearch;
+
+#endif // KEYSEARCH_H
@@ -0,0 +1,155 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/17/2026
+ */
+
+#include <cstring>
+#include <stdint.h>
+#include "LZCodec.h"
+
+static const int MIN_MATCH = 4;      // shorter repeats are stored as literals
+static const int LAST_LITERALS = 5;  // a block always ends with this many literals
+static const int MAX_OFFSET = 65535; // offsets are stored in two bytes
+static const int HASH_BITS = 12;
+
+static inline uint32_t read32(const char* p)
+{
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline int hash32(uint32_t v)
+{
+  return (int)((v * 2654435761U) >> (32 - HASH_BITS));
+}
+
+// append a length that did not fit in the token. returns the new output
+// position, or NULL if the output is full
+static char* putLength(char* out, const char* end, int len)
+{
+  for (; len >= 255; len -= 255) {
+    if (out >= end) return NULL;
+    *out++ = (char)255;
+  }
+  if (out >= end) return NULL;
+  *out++ = (char)len;
+  return out;
+}
+
+// append one sequence: literals, then a match unless matchLen is 0
+static char* putSequence(char* out, const char* end, const char* lit, int litLen, int offset, int matchLen)
+{
+  char* token = out++;
+  int   m = (matchLen > 0) ? matchLen - MIN_MATCH : 0;
+
+  if (token >= end) return NULL;
+  *token = (char)(((litLen < 15 ? litLen : 15) << 4) | (m < 15 ? m : 15));
+
+  if (litLen >= 15 && (out = putLength(out, end, litLen - 15)) == NULL) return NULL;
+  if (end - out < litLen) return NULL;
+  memcpy(out, lit, litLen);
+  out += litLen;
+
+  if (matchLen > 0) {
+    if (end - out < 2) return NULL;
+    *out++ = (char)(offset & 0xff);
+    *out++ = (char)(offset >> 8);
+    if (m >= 15 && (out = putLength(out, end, m - 15)) == NULL) return NULL;
+  }
+
+  return out;
+}
+
+int LZCodec::compress(const char* src, int srcLen, char* dst, int dstCap)
+{
+  int   table[1 << HASH_BITS];
+  char* out = dst;
+  char* end = dst + dstCap;
+  int   anchor = 0;  // the first byte not emitted yet
+  int   i = 0;
+  const int limit = srcLen - LAST_LITERALS - MIN_MATCH; // the last position a match may start at
+
+  for (int h = 0; h < (1 << HASH_BITS); h++) table[h] = -1;
+
+  while (i <= limit) {
+    uint32_t seq = read32(src + i);
+    int h = hash32(seq);
+    int candidate = table[h];
+    table[h] = i;
+
+    if (candidate < 0 || i - candidate > MAX_OFFSET || read32(src + candidate) != seq) {
+      i++;
+      continue;
+    }
+
+    // extend the match, keeping the last bytes as literals
+    int len = MIN_MATCH;
+    while (i + len < srcLen - LAST_LITERALS && src[candidate + len] == src[i + len]) len++;
+
+    if ((out = putSequence(out, end, src + anchor, i - anchor, i - candidate, len)) == NULL) return -1;
+    i += len;
+    anchor = i;
+  }
+
+  // the rest of the block is literals
+  if ((out = putSequence(out, end, src + anchor, srcLen - anchor, 0, 0)) == NULL) return -1;
+
+  return (int)(out - dst);
+}
+
+// read a length that did not fit in the token. returns -1 past the end
+static int getLength(const unsigned char*& in, const unsigned char* end, int len)
+{
+  unsigned char b;
+
+  do {
+    if (in >= end) return -1;
+    b = *in++;
+    len += b;
+  } while (b == 255);
+
+  return len;
+}
+
+int LZCodec::decompress(const char* src, int srcLen, char* dst, int dstLen)
+{
+  const unsigned char* in = (const unsigned char*)src;
+  const unsigned char* inEnd = in + srcLen;
+  char* out = dst;
+  char* outEnd = dst + dstLen;
+
+  while (in < inEnd) {
+    int token = *in++;
+
+    // copy the literals
+    int litLen = token >> 4;
+    if (litLen == 15 && (litLen = getLength(in, inEnd, 15)) < 0) return -1;
+    if (inEnd - in < litLen || outEnd - out < litLen) return -1;
+    memcpy(out, in, litLen);
+    in += litLen;
+    out += litLen;
+
+    // the last sequence has no match
+    if (in == inEnd) break;
+
+    if (inEnd - in < 2) return -1;
+    int offset = in[0] | (in[1] << 8);
+    in += 2;
+
+    int matchLen = token & 15;
+    if (matchLen == 15 && (matchLen = getLength(in, inEnd, 15)) < 0) return -1;
+    matchLen += MIN_MATCH;
+
+    if (offset == 0 || offset > out - dst || outEnd - out < matchLen) return -1;
+
+    // the match may overlap the bytes it produces, so copy byte by byte
+    const char* from = out - offset;
+    for (int k = 0; k < matchLen; k++) out[k] = from[k];
+    out += matchLen;
+  }
+
+  return (out == outEnd) ? dstLen : -1;
+}
@@ -0,0 +1,47 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/17/2026
+ */
+
+#ifndef LZCODEC_H
+#define LZCODEC_H
+
+/**
+ * A small, fast LZ77 codec for compressing single pages.
+ *
+ * The compressed data is a series of sequences, each made of a token byte,
+ * literal bytes copied as is, and a match copying bytes seen earlier:
+ *   token:   the # of literals (high 4 bits) and the match length - 4
+ *            (low 4 bits). the value 15 means that more length bytes
+ *            follow, each adding 0-255 until one is less than 255
+ *   literals
+ *   offset:  2 bytes (little endian), how far back the match starts
+ * The last sequence has literals only. This is close to the LZ4 block
+ * format, which is well suited to pages full of zeros and short strings.
+ */
+class LZCodec {
+ public:
+  /**
+   * compress a block.
+   * @param src[IN] the data to compress
+   * @param srcLen[IN] the # of bytes in src
+   * @param dst[OUT] the buffer for the compressed data
+   * @param dstCap[IN] the size of dst
+   * @return the compressed size, or -1 if it would exceed dstCap
+   */
+  static int compress(const char* src, int srcLen, char* dst, int dstCap);
+
+  /**
+   * decompress a block.
+   * @param src[IN] the compressed data
+   * @param srcLen[IN] the # of bytes in src
+   * @param dst[OUT] the buffer for the original data
+   * @param dstLen[IN] the size of the original data
+   * @return dstLen, or -1 if src is corrupt
+   */
+  static int decompress(const char* src, int srcLen, char* dst, int dstLen);
+};
+
+#endif // LZCODEC_H
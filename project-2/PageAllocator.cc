@@ -0,0 +1,189 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/17/2026
+ */
+
+#include "PageAllocator.h"
+#include <fcntl.h>
+#include <unistd.h>
+
+using std::string;
+
+PageAllocator::PageAllocator()
+{
+  pf = NULL;
+  end = 0;
+  dirty = false;
+}
+
+RC PageAllocator::open(PageFile& pf, const string& filename)
+{
+  this->pf = &pf;
+  mapName = filename + ".fsm";
+  used.clear();
+  extents.clear();
+  end = 0;
+  dirty = true;
+
+  // a map next to an empty file is left over from an earlier file
+  if (pf.endPid() <= 0) {
+    ::unlink(mapName.c_str());
+    return 0;
+  }
+
+  // the map is removed while the file is open, so that after a crash every
+  // page is taken as used rather than a page allocated since being freed.
+  // pages beyond the map were written without it and are in use too
+  if (load() < 0) {
+    used.clear();
+    end = 0;
+  }
+  ::unlink(mapName.c_str());
+  PageId known = end;
+  PageId epid = pf.endPid();
+  if (epid > end) {
+    end = (epid + PageFile::EXTENT_PAGES - 1) / PageFile::EXTENT_PAGES * PageFile::EXTENT_PAGES;
+    used.resize((end + 7) / 8, 0);
+  }
+  for (PageId pid = known; pid < epid; pid++) setUsed(pid, true);
+
+  return 0;
+}
+
+RC PageAllocator::close()
+{
+  RC rc = 0;
+
+  if (pf != NULL) rc = save();
+  pf = NULL;
+  used.clear();
+  extents.clear();
+  end = 0;
+  return rc;
+}
+
+void PageAllocator::setUsed(PageId pid, bool on)
+{
+  if (on) {
+    used[pid / 8] |= (unsigned char)(1 << (pid % 8));
+  } else {
+    used[pid / 8] &= (unsigned char)~(1 << (pid % 8));
+  }
+  dirty = true;
+}
+
+RC PageAllocator::allocate(PageId hint, int group, PageId& pid)
+{
+  RC rc;
+
+  if (pf == NULL) return RC_FILE_WRITE_FAILED;
+  if (group < 0) return RC_INVALID_ATTRIBUTE;
+  if (group >= (int)extents.size()) extents.resize(group + 1, -1);
+
+  // look for a free page after the hint, in its extent. a page before the
+  // hint would be read backwards by a scan going from the hint to it
+  if (hint >= 0 && hint < end && (hint + 1) % PageFile::EXTENT_PAGES != 0 &&
+      findFree(hint + 1, pid)) {
+    setUsed(pid, true);
+    return 0;
+  }
+
+  // otherwise any free page of the extent of the group will do, unless it
+  // is the extent of the hint: its free pages are all before the hint
+  const PageId hintExtent = (hint >= 0) ? hint - hint % PageFile::EXTENT_PAGES : -1;
+  if (extents[group] >= 0 && extents[group] != hintExtent && findFree(extents[group], pid)) {
+    setUsed(pid, true);
+    return 0;
+  }
+
+  // the extent is full: give the group a new one at the end of the file
+  if ((rc = grow()) < 0) return rc;
+  pid = extents[group] = end - PageFile::EXTENT_PAGES;
+  setUsed(pid, true);
+
+  return 0;
+}
+
+bool PageAllocator::findFree(PageId from, PageId& pid) const
+{
+  const PageId last = from - from % PageFile::EXTENT_PAGES + PageFile::EXTENT_PAGES;
+
+  for (pid = from; pid < last; pid++) {
+    if (!isUsed(pid)) return true;
+  }
+  return false;
+}
+
+RC PageAllocator::release(PageId pid)
+{
+  if (pf == NULL) return RC_FILE_WRITE_FAILED;
+  if (pid < 0 || pid >= end) return RC_INVALID_PID;
+
+  setUsed(pid, false);
+  return 0;
+}
+
+RC PageAllocator::grow()
+{
+  RC rc;
+
+  // reserve the disk space of the whole extent at once
+  if ((rc = pf->reserve(end, PageFile::EXTENT_PAGES)) < 0) return rc;
+
+  end += PageFile::EXTENT_PAGES;
+  used.resize((end + 7) / 8, 0);
+  return 0;
+}
+
+RC PageAllocator::load()
+{
+  int  header[2];
+  long long count;
+  int  mfd;
+
+  // the map is a header (magic, extent size, # of pages covered)
+  // followed by the bitmap of the pages in use
+  if ((mfd = ::open(mapName.c_str(), O_RDONLY)) < 0) return RC_FILE_OPEN_FAILED;
+  if (::pread(mfd, header, sizeof(header), 0) != sizeof(header) ||
+      ::pread(mfd, &count, sizeof(count), sizeof(header)) != sizeof(count) ||
+      header[0] != FSM_MAGIC || header[1] != PageFile::EXTENT_PAGES ||
+      count < 0 || count % PageFile::EXTENT_PAGES != 0) {
+    ::close(mfd);
+    return RC_INVALID_FILE_FORMAT;
+  }
+
+  used.resize((count + 7) / 8);
+  ssize_t bytes = (ssize_t)used.size();
+  if (bytes > 0 && ::pread(mfd, &used[0], bytes, sizeof(header) + sizeof(count)) != bytes) {
+    ::close(mfd);
+    return RC_INVALID_FILE_FORMAT;
+  }
+  ::close(mfd);
+
+  end = count;
+  return 0;
+}
+
+RC PageAllocator::save()
+{
+  int  header[2] = { FSM_MAGIC, PageFile::EXTENT_PAGES };
+  long long count = end;
+  int  mfd;
+
+  if (!dirty) return 0;
+
+  if ((mfd = ::open(mapName.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644)) < 0) return RC_FILE_WRITE_FAILED;
+  ssize_t bytes = (ssize_t)used.size();
+  if (::write(mfd, header, sizeof(header)) != sizeof(header) ||
+      ::write(mfd, &count, sizeof(count)) != sizeof(count) ||
+      (bytes > 0 && ::write(mfd, &used[0], bytes) != bytes)) {
+    ::close(mfd);
+    return RC_FILE_WRITE_FAILED;
+  }
+  if (::close(mfd) < 0) return RC_FILE_WRITE_FAILED;
+
+  dirty = false;
+  return 0;
+}
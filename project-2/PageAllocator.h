@@ -0,0 +1,91 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/17/2026
+ */
+
+#ifndef PAGEALLOCATOR_H
+#define PAGEALLOCATOR_H
+
+#include <string>
+#include <vector>
+#include "Bruinbase.h"
+#include "PageFile.h"
+
+/**
+ * Hands out the pages of a PageFile whose pages are linked to each other
+ * (e.g., the nodes of a B+tree), instead of always appending at endPid().
+ *
+ * The file is divided into extents of PageFile::EXTENT_PAGES pages whose
+ * disk space is reserved as a whole. A new page is placed in the extent of
+ * a hint page, right after it if possible, so that pages which are read
+ * one after the other (e.g., the leaves of a B+tree) stay contiguous on
+ * disk. It is never placed before the hint, where such reads would go
+ * backwards. When the extent of the hint has no free page after the hint,
+ * the page goes to the extent the allocator is filling for the group of
+ * the page, and when that is full too, to a new extent. Pages of different
+ * groups (e.g., leaf and non-leaf nodes) never share such an extent, so
+ * that they do not end up interleaved on disk.
+ *
+ * Which pages are in use is kept in a free-space map, one bit per page,
+ * stored next to the file (filename + ".fsm") when the allocator is closed.
+ * Without a map, e.g., after a crash, every page below endPid() is taken
+ * as used.
+ * An allocator must not be used from several threads at once.
+ */
+class PageAllocator {
+ public:
+  PageAllocator();
+
+  /**
+   * start allocating the pages of a file opened in 'w' mode,
+   * loading its free-space map.
+   * @param pf[IN] the file, which must stay open until close()
+   * @param filename[IN] the name the file was opened with
+   * @return error code. 0 if no error
+   */
+  RC open(PageFile& pf, const std::string& filename);
+
+  /**
+   * save the free-space map. must be called before the file is closed.
+   * @return error code. 0 if no error
+   */
+  RC close();
+
+  /**
+   * allocate a page and reserve disk space for it. the page is not written.
+   * @param hint[IN] a page the new page is going to be read together with,
+   *   or INVALID_PID (-1) if there is none
+   * @param group[IN] the kind of the page, a small number (0, 1, ...)
+   * @param pid[OUT] the page allocated
+   * @return error code. 0 if no error
+   */
+  RC allocate(PageId hint, int group, PageId& pid);
+
+  /**
+   * return a page to the free-space map, to be allocated again.
+   * @param pid[IN] the page to release
+   * @return error code. 0 if no error
+   */
+  RC release(PageId pid);
+
+ private:
+  bool isUsed(PageId pid) const { return (used[pid / 8] >> (pid % 8)) & 1; }
+  void setUsed(PageId pid, bool on);
+  bool findFree(PageId from, PageId& pid) const;
+  RC   grow();
+  RC   load();
+  RC   save();
+
+  static const int FSM_MAGIC = 0x4d534642; // "BFSM"
+
+  PageFile* pf;
+  std::string mapName;               // the name of the free-space map file
+  std::vector<unsigned char> used;   // one bit per page of the extents handed out
+  std::vector<PageId> extents;       // the extent each group is filling, or -1
+  PageId end;                        // the end of the last extent handed out
+  bool   dirty;                      // whether used differs from the map file
+};
+
+#endif // PAGEALLOCATOR_H
@@ -9,30 +9,177 @@
 
 #include "Bruinbase.h"
 #include "PageFile.h"
+#include "AsyncIO.h"
+#include "LZCodec.h"
+#include "IOStats.h"
+#include "WriteAheadLog.h"
+#include "PageTrace.h"
+#include <map>
+#include <vector>
+#include <cstdio>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
 #include <fcntl.h>
+#include <unistd.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/sysmacros.h>
+#include <sys/uio.h>
+#include <climits>
 
 using std::string;
 
-int PageFile::readCount = 0;
-int PageFile::writeCount = 0;
-int PageFile::cacheClock = 1;
-struct PageFile::cacheStruct PageFile::readCache[PageFile::CACHE_COUNT];
+const char* const PageFile::CACHE_FILE = "bruinbase.cache";
+std::atomic<long long> PageFile::readCount(0);
+std::atomic<long long> PageFile::writeCount(0);
+int PageFile::defaultFlags = 0;
+std::set<PageFile*> PageFile::openFiles;
+std::mutex PageFile::openLatch;
+BufferPool PageFile::cache(PageFile::PAGE_SIZE, PageFile::DEFAULT_CACHE_SIZE / PageFile::PAGE_SIZE);
+
+// std::min() takes its arguments by reference, so these need a definition
+const int PageFile::PAGE_SIZE;
+const size_t PageFile::MMAP_RESERVE;
+
+// return the page cache id of the unix file described by statbuf.
+// the same file always gets the same id, no matter how often it is opened.
+static int cacheFileId(const struct stat& statbuf)
+{
+  static std::map<std::pair<dev_t, ino_t>, int> ids;
+  static std::mutex latch;
+  std::lock_guard<std::mutex> guard(latch);
+
+  std::pair<dev_t, ino_t> inode(statbuf.st_dev, statbuf.st_ino);
+  std::map<std::pair<dev_t, ino_t>, int>::iterator it = ids.find(inode);
+  if (it != ids.end()) return it->second;
+
+  int fid = (int)ids.size() + 1;
+  ids[inode] = fid;
+  return fid;
+}
+
+// read the buffers of iov from offset on, going on after short reads.
+// what lies past the end of the file reads as zeros, like a page that
+// was never written, so that no buffer keeps stale content
+static RC readFully(int fd, struct iovec* iov, int count, long long offset)
+{
+  while (count > 0) {
+    ssize_t got = ::preadv(fd, iov, count, offset);
+    if (got < 0 && errno == EINTR) continue;
+    if (got < 0) return RC_FILE_READ_FAILED;
+    if (got == 0) {
+      for (int i = 0; i < count; i++) memset(iov[i].iov_base, 0, iov[i].iov_len);
+      return 0;
+    }
+
+    // skip what was read
+    offset += got;
+    for (; count > 0 && (size_t)got >= iov->iov_len; iov++, count--) got -= iov->iov_len;
+    if (count > 0) {
+      iov->iov_base = (char*)iov->iov_base + got;
+      iov->iov_len -= got;
+    }
+  }
+  return 0;
+}
+
+// find out the alignment that O_DIRECT transfers on the open file fd need:
+// of their offsets and lengths in the file, and of their buffers in memory.
+// statx() tells on Linux 6.1 or later. otherwise the logical block size of
+// the device the file is on (as BLKSSZGET reports it) stands for both, and
+// if that is not known either, 4KB is assumed.
+// return false if the file does not support O_DIRECT at all
+static bool directAlignment(int fd, size_t& offsetAlign, size_t& memAlign)
+{
+  struct stat statbuf;
+  char path[96];
+  FILE* fp;
+  unsigned long size = 0;
+
+  offsetAlign = memAlign = 4096;
+
+#ifdef STATX_DIOALIGN
+  struct statx stx;
+  if (::statx(fd, "", AT_EMPTY_PATH, STATX_DIOALIGN, &stx) == 0 && (stx.stx_mask & STATX_DIOALIGN)) {
+    offsetAlign = stx.stx_dio_offset_align;
+    memAlign = stx.stx_dio_mem_align;
+    return offsetAlign > 0 && memAlign > 0;
+  }
+#endif
+
+  // the queue of a partition is that of its disk, one directory up
+  if (::fstat(fd, &statbuf) < 0) return true;
+  for (int up = 0; up < 2 && size == 0; up++) {
+    snprintf(path, sizeof(path), "/sys/dev/block/%u:%u/%squeue/logical_block_size",
+             major(statbuf.st_dev), minor(statbuf.st_dev), up ? "../" : "");
+    if ((fp = fopen(path, "r")) == NULL) continue;
+    if (fscanf(fp, "%lu", &size) != 1) size = 0;
+    fclose(fp);
+  }
+  if (size > 0) offsetAlign = memAlign = size;
+  return true;
+}
 
 PageFile::PageFile() 
 { 
   fd = -1; 
+  fid = 0;
   epid = 0; 
+  flags = 0;
+  map = NULL;
+  mapSize = 0;
+  mapWrite = false;
+  stats = NULL;
+  version = FORMAT_VERSION;
+  base = 1;
+  dataEnd = 0;
+  slotsDirty = false;
+  resetReadAhead();
 }
 
 PageFile::PageFile(const string& filename, char mode)
 {
   fd = -1;
+  fid = 0;
   epid = 0;
+  flags = 0;
+  map = NULL;
+  mapSize = 0;
+  mapWrite = false;
+  stats = NULL;
+  version = FORMAT_VERSION;
+  base = 1;
+  dataEnd = 0;
+  slotsDirty = false;
+  resetReadAhead();
   open(filename.c_str(), mode);
 }
 
+PageFile::~PageFile()
+{
+  // make sure no dirty page is left behind for a file that is gone
+  if (fd >= 0) close();
+}
+
+RC PageFile::setCacheSize(size_t bytes)
+{
+  return cache.resize((int)(bytes / PAGE_SIZE));
+}
+
+RC PageFile::setCachePolicy(const string& policy)
+{
+  if (policy == "lru") return cache.setPolicy(new LRUPolicy);
+  if (policy == "clock") return cache.setPolicy(new ClockPolicy);
+  return RC_INVALID_ATTRIBUTE;
+}
+
 RC PageFile::open(const string& filename, char mode)
+{
+  return open(filename, mode, defaultFlags);
+}
+
+RC PageFile::open(const string& filename, char mode, int flags)
 {
   RC   rc;
   int  oflag;
@@ -40,6 +187,9 @@ RC PageFile::open(const string& filename, char mode)
 
   if (fd > 0) return RC_FILE_OPEN_FAILED;
 
+  // the pages left in the write-ahead log by a crash are redone first
+  if ((rc = WriteAheadLog::recover()) < 0) return rc;
+
   // set the unix file flag depending on the file mode
   switch (mode) {
   case 'r':
@@ -54,37 +204,183 @@ RC PageFile::open(const string& filename, char mode)
     return RC_INVALID_FILE_MODE;
   }
 
-  // open the file
-  fd = ::open(filename.c_str(), oflag, 0644);
+  // a page map next to a non-empty file means that its pages are compressed.
+  // a stale page map next to an empty file is removed
+  struct stat oldbuf;
+  bool empty = (::stat(filename.c_str(), &oldbuf) < 0 || oldbuf.st_size == 0);
+  mapName = filename + ".map";
+  if (!empty && ::access(mapName.c_str(), F_OK) == 0) {
+    flags |= COMPRESS;
+  } else {
+    if (empty && oflag != O_RDONLY) ::unlink(mapName.c_str());
+    if (!empty || oflag == O_RDONLY) flags &= ~COMPRESS;
+  }
+  if (flags & COMPRESS) flags &= ~(MMAP | DIRECT);
+
+  // open the file. O_DIRECT is refused by some file systems (e.g., tmpfs),
+  // and cannot be used where the pages, the header page among them, or the
+  // frames they are read into are smaller than the alignment it needs, e.g.,
+  // 1KB pages on a device with 4KB blocks. such files are read through the
+  // OS page cache as usual
+  if ((flags & DIRECT) && !(flags & MMAP)) {
+    fd = ::open(filename.c_str(), oflag | O_DIRECT, 0644);
+    if (fd < 0 && errno == EINVAL) flags &= ~DIRECT;
+    if (fd >= 0) {
+      size_t offsetAlign, memAlign;
+      size_t frameAlign = (PAGE_SIZE < BufferPool::FRAME_ALIGNMENT) ? PAGE_SIZE : BufferPool::FRAME_ALIGNMENT;
+      if (!directAlignment(fd, offsetAlign, memAlign) ||
+          PAGE_SIZE % offsetAlign != 0 || frameAlign % memAlign != 0) {
+        ::close(fd);
+        fd = -1;
+        flags &= ~DIRECT;
+      }
+    }
+  } else {
+    flags &= ~DIRECT;
+  }
+  if (!(flags & DIRECT)) fd = ::open(filename.c_str(), oflag, 0644);
   if (fd < 0) { fd = -1; return RC_FILE_OPEN_FAILED; }
 
   // get the size of the file to set the end pid
   rc = ::fstat(fd, &statbuf);
   if (rc < 0) { ::close(fd); fd = -1; return RC_FILE_OPEN_FAILED; }
-  epid = statbuf.st_size / PAGE_SIZE;
+
+  // find out the format of the file, writing the header of a new file.
+  // compressed files have no header page; the page map tells their version
+  base = 0;
+  if (!(flags & COMPRESS) && (rc = readHeader(filename, statbuf.st_size, oflag != O_RDONLY)) < 0) {
+    ::close(fd);
+    fd = -1;
+    return rc;
+  }
+  epid = std::max(0LL, (long long)statbuf.st_size / PAGE_SIZE - base);
+
+  // the pages of a compressed file are listed in its page map
+  if ((flags & COMPRESS) && (rc = loadPageMap(statbuf.st_size == 0)) < 0) {
+    ::close(fd);
+    fd = -1;
+    return rc;
+  }
+
+  // pages cached for an earlier file with the same inode are stale
+  fid = cacheFileId(statbuf);
+  stats = FileStats::get(fid, filename);
+  if (epid == 0) cache.invalidateFile(fid);
+
+  // map the file if requested
+  this->flags = flags;
+  mapWrite = (oflag != O_RDONLY);
+
+  // the page map of a compressed file tells its format, as the header page
+  // does for the others, and is saved as soon as the file is created
+  if ((flags & COMPRESS) && statbuf.st_size == 0 && WriteAheadLog::isOpen() && (rc = savePageMap()) < 0) {
+    ::close(fd);
+    fd = -1;
+    return rc;
+  }
+  if ((flags & MMAP) && (rc = mapFile()) < 0) {
+    ::close(fd);
+    fd = -1;
+    return rc;
+  }
+
+  // dirty pages are written back through this object
+  if ((flags & WRITE_BACK) && !(flags & MMAP)) cache.setStore(fid, this);
+
+  resetReadAhead();
+
+  name = filename;
+  std::lock_guard<std::mutex> guard(openLatch);
+  openFiles.insert(this);
+
+  return 0;
+}
+
+RC PageFile::readHeader(const string& filename, long long size, bool create)
+{
+  // the header fills a whole page, so that O_DIRECT transfers work on it
+  alignas(BufferPool::FRAME_ALIGNMENT) char page[PAGE_SIZE];
+  FileHeader header;
+
+  // a new file gets a header of the current version
+  if (size == 0) {
+    version = FORMAT_VERSION;
+    base = 1;
+    if (!create) return 0;
+
+    header.magic = FILE_MAGIC;
+    header.version = FORMAT_VERSION;
+    header.pageSize = PAGE_SIZE;
+    memset(page, 0, PAGE_SIZE);
+    memcpy(page, &header, sizeof(header));
+    if (::pwrite(fd, page, PAGE_SIZE, 0) != PAGE_SIZE) return RC_FILE_WRITE_FAILED;
+
+    // the log holds pages, not the header: a file whose pages are logged
+    // must not lose it in a crash, or the pages would be redone one page off
+    if (WriteAheadLog::isOpen()) {
+      if (::fdatasync(fd) < 0) return RC_FILE_WRITE_FAILED;
+      return syncDirectory(filename);
+    }
+    return 0;
+  }
+
+  if (::pread(fd, page, PAGE_SIZE, 0) < (ssize_t)sizeof(header)) return RC_FILE_READ_FAILED;
+  memcpy(&header, page, sizeof(header));
+
+  // a file without a header predates it: its pages start at offset 0.
+  // but a first page of zeros followed by other pages is a header that
+  // never reached the disk, and reading the file as version 1 would shift
+  // its pages (WriteAheadLog::recover() fails on it instead)
+  if (header.magic != FILE_MAGIC) {
+    bool zeros = true;
+    for (int i = 0; i < PAGE_SIZE && zeros; i++) zeros = (page[i] == 0);
+    if (zeros && size > PAGE_SIZE) return RC_INVALID_FILE_FORMAT;
+
+    version = 1;
+    base = 0;
+    return 0;
+  }
+
+  if (header.version < 2 || header.version > FORMAT_VERSION || header.pageSize != PAGE_SIZE) {
+    return RC_INVALID_FILE_FORMAT;
+  }
+  version = header.version;
+  base = 1;
 
   return 0;
 }
 
 RC PageFile::close()
 {
+  RC rc;
+
   if (fd <= 0) return RC_FILE_CLOSE_FAILED;
 
+  {
+    std::lock_guard<std::mutex> guard(openLatch);
+    openFiles.erase(this);
+  }
+
+  // write back the dirty pages of the file
+  if ((rc = flush()) < 0) return rc;
+  cache.setStore(fid, NULL);
+
+  // flush and drop the mapping
+  if (map != NULL && (rc = unmapFile()) < 0) return rc;
+
   // close the file
   if (::close(fd) < 0) return RC_FILE_CLOSE_FAILED;
 
-  // evict all cached pages for this file
-  for (int i = 0; i < CACHE_COUNT; i++) {
-    if (readCache[i].fd == fd && readCache[i].lastAccessed != 0) {
-       readCache[i].fd = 0;
-       readCache[i].pid = 0;
-       readCache[i].lastAccessed = 0;
-    }
-  }
+  // cached pages of the file are kept for the next open()
 
   // set the fd and epid to the initial state
   fd = -1; 
+  fid = 0;
   epid = 0;
+  flags = 0;
+  slots.clear();
+  freeSpace.clear();
+  freedSlots.clear();
   return 0;
 }
 
@@ -93,86 +389,743 @@ PageId PageFile::endPid() const
   return epid;
 }
 
-RC PageFile::seek(PageId pid) const
+RC PageFile::flush()
 {
-  return (::lseek(fd, pid * PAGE_SIZE, SEEK_SET) < 0) ? RC_FILE_SEEK_FAILED : 0;
+  RC rc;
+
+  if (fd < 0) return 0;
+  if ((rc = cache.flush(fid)) < 0) return rc;
+
+  // the page map has to describe the pages written
+  return (flags & COMPRESS) ? savePageMap() : 0;
 }
 
-RC PageFile::write(PageId pid, const void* buffer)
+RC PageFile::flushOpenFiles()
 {
   RC rc;
-  if (pid < 0) return RC_INVALID_PID; 
+  std::lock_guard<std::mutex> guard(openLatch);
 
-  // seek to the location of the page
-  if ((rc = seek(pid) < 0)) return rc;
+  for (std::set<PageFile*>::iterator it = openFiles.begin(); it != openFiles.end(); ++it) {
+    if ((rc = (*it)->flush()) < 0) return rc;
+  }
+  return 0;
+}
+
+RC PageFile::savePageMaps()
+{
+  RC rc;
+  std::lock_guard<std::mutex> guard(openLatch);
 
-  // write the buffer to the disk page
-  if (::write(fd, buffer, PAGE_SIZE) < 0) return RC_FILE_WRITE_FAILED;
+  for (std::set<PageFile*>::iterator it = openFiles.begin(); it != openFiles.end(); ++it) {
+    if (((*it)->flags & COMPRESS) && (rc = (*it)->savePageMap()) < 0) return rc;
+  }
+  return 0;
+}
+
+RC PageFile::replaceFile(const string& path, const void* data, size_t length, bool sync)
+{
+  string tmp = path + ".tmp";
+  int tfd;
 
-  // if the page is in read cache, invalidate it
-  for (int i = 0; i < CACHE_COUNT; i++) {
-    if (readCache[i].fd == fd && readCache[i].pid == pid &&
-        readCache[i].lastAccessed != 0) {
-       readCache[i].fd = 0;
-       readCache[i].pid = 0;
-       readCache[i].lastAccessed = 0;
-       break;
+  if ((tfd = ::open(tmp.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644)) < 0) return RC_FILE_WRITE_FAILED;
+  for (size_t done = 0; done < length; ) {
+    ssize_t n = ::write(tfd, (const char*)data + done, length - done);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) {
+      ::close(tfd);
+      ::unlink(tmp.c_str());
+      return RC_FILE_WRITE_FAILED;
     }
+    done += n;
   }
 
-  // if the written pid >= end pid, update the end pid
-  if (pid >= epid) epid = pid + 1;
+  // the new content has to be on disk before the name points to it
+  bool failed = (sync && ::fsync(tfd) < 0);
+  if (::close(tfd) < 0) failed = true;
+  if (failed || ::rename(tmp.c_str(), path.c_str()) < 0) {
+    ::unlink(tmp.c_str());
+    return RC_FILE_WRITE_FAILED;
+  }
+  return sync ? syncDirectory(path) : 0;
+}
+
+RC PageFile::syncDirectory(const string& path)
+{
+  string::size_type slash = path.rfind('/');
+  string dir = (slash == string::npos) ? "." : (slash == 0) ? "/" : path.substr(0, slash);
+  int dfd;
+
+  if ((dfd = ::open(dir.c_str(), O_RDONLY|O_DIRECTORY)) < 0) return RC_FILE_OPEN_FAILED;
+  int rc = ::fsync(dfd);
+  ::close(dfd);
+  return (rc < 0) ? RC_FILE_WRITE_FAILED : 0;
+}
+
+RC PageFile::saveCache(const string& path)
+{
+  std::vector<PageKey> keys;
+  std::vector<int> fids;
+  std::vector<const FileStats*> files;
+  std::map<int, std::vector<PageId> > pages;
+  string tmp = path + ".tmp";
+  FILE* fp;
+
+  cache.getCachedPages(keys);
+  for (unsigned i = 0; i < keys.size(); i++) pages[keys[i].fid].push_back(keys[i].pid);
+
+  if ((fp = fopen(tmp.c_str(), "w")) == NULL) return RC_FILE_OPEN_FAILED;
+
+  // one "pid filename" line per page, with the pages of a file in order
+  fprintf(fp, "bruinbase cache %d\n", PAGE_SIZE);
+  FileStats::list(fids, files);
+  for (unsigned i = 0; i < fids.size(); i++) {
+    std::vector<PageId>& pids = pages[fids[i]];
+    std::sort(pids.begin(), pids.end());
+    for (unsigned j = 0; j < pids.size(); j++) {
+      fprintf(fp, "%lld %s\n", (long long)pids[j], files[i]->name.c_str());
+    }
+  }
+
+  // replace the old list only once the new one is complete
+  if (fclose(fp) != 0 || ::rename(tmp.c_str(), path.c_str()) < 0) {
+    ::unlink(tmp.c_str());
+    return RC_FILE_WRITE_FAILED;
+  }
+  return 0;
+}
+
+RC PageFile::loadCache(const string& path)
+{
+  RC   rc = 0;
+  int  pageSize;
+  long long pid;
+  char name[1024];
+  FILE* fp;
+  std::vector<string> names;
+  std::map<string, std::vector<PageId> > pages;
+
+  if ((fp = fopen(path.c_str(), "r")) == NULL) return RC_FILE_OPEN_FAILED;
+
+  // pages recorded by a build with another page size are of no use
+  if (fscanf(fp, "bruinbase cache %d\n", &pageSize) != 1 || pageSize != PAGE_SIZE) {
+    fclose(fp);
+    return RC_INVALID_FILE_FORMAT;
+  }
+  while (fscanf(fp, "%lld %1023[^\n]\n", &pid, name) == 2) {
+    if (pages.find(name) == pages.end()) names.push_back(name);
+    pages[name].push_back(pid);
+  }
+  fclose(fp);
+
+  // read the files one after the other, in the order they were recorded
+  for (unsigned i = 0; i < names.size() && rc >= 0; i++) {
+    PageFile pf;
+    if (pf.open(names[i], 'r') < 0) continue;
+    rc = pf.prewarm(pages[names[i]]);
+    pf.close();
+  }
+  return rc;
+}
+
+RC PageFile::writePages(PageId pid, const char* const* pages, int n)
+{
+  struct iovec iov[IOV_MAX];
+  RC rc;
+  
+  if (n > IOV_MAX) return RC_FILE_WRITE_FAILED;
+
+  // compressed pages are stored one by one, wherever they fit
+  if (flags & COMPRESS) {
+    for (int i = 0; i < n; i++) {
+      if ((rc = writeCompressed(pid + i, pages[i])) < 0) return rc;
+    }
+    writeCount += n;
+    return 0;
+  }
+
+  // write the whole run with a single system call
+  for (int i = 0; i < n; i++) {
+    iov[i].iov_base = const_cast<char*>(pages[i]);
+    iov[i].iov_len = PAGE_SIZE;
+  }
+  long long start = FileStats::now();
+  if (::pwritev(fd, iov, n, offsetOf(pid)) != (ssize_t)n * PAGE_SIZE) {
+    return RC_FILE_WRITE_FAILED;
+  }
+  stats->recordWrite(n, (long long)n * PAGE_SIZE, start);
 
   // increase page write count
-  writeCount++;
+  writeCount += n;
 
   return 0;
 }
 
-RC PageFile::read(PageId pid, void* buffer) const
+RC PageFile::readPage(PageId pid, char* page) const
+{
+  if (flags & COMPRESS) return readCompressed(pid, page);
+
+  // read the page at its offset; the file cursor is not used
+  struct iovec iov = { page, PAGE_SIZE };
+  long long start = FileStats::now();
+  if (readFully(fd, &iov, 1, offsetOf(pid)) < 0) return RC_FILE_READ_FAILED;
+  stats->recordRead(1, PAGE_SIZE, start);
+
+  // increase the page read count
+  readCount++;
+
+  return 0;
+}
+
+RC PageFile::readPages(const PageId* pids, char* const* pages, int n) const
 {
+  static AsyncIO* io = AsyncIO::create(PREFETCH_DEPTH);
+  static std::mutex latch;
+  std::vector<AsyncIO::Request> reqs;
+  struct iovec iov[IOV_MAX];
   RC rc;
 
-  if (pid < 0 || pid >= epid) return RC_INVALID_PID; 
+  // compressed pages have to be read and decompressed one by one
+  if (flags & COMPRESS) return PageStore::readPages(pids, pages, n);
 
-  //
-  // if the page is in cache, read it from there
-  //
-  for (int i = 0; i < CACHE_COUNT; i++) {
-    if (readCache[i].fd == fd && readCache[i].pid == pid && 
-        readCache[i].lastAccessed != 0) {
-       memcpy(buffer, readCache[i].buffer, PAGE_SIZE);
-       readCache[i].lastAccessed = ++cacheClock;
-       return 0;
+  for (int i = 0, run; i < n; i += run) {
+    // a run of consecutive pages is read with one large read
+    for (run = 1; i + run < n && run < IOV_MAX && pids[i + run] == pids[i] + run; run++) { }
+    if (run > 1) {
+      for (int j = 0; j < run; j++) {
+        iov[j].iov_base = pages[i + j];
+        iov[j].iov_len = PAGE_SIZE;
+      }
+      long long start = FileStats::now();
+      if (readFully(fd, iov, run, offsetOf(pids[i])) < 0) return RC_FILE_READ_FAILED;
+      stats->recordRead(run, (long long)run * PAGE_SIZE, start);
+      continue;
     }
+
+    // scattered pages are read in parallel
+    AsyncIO::Request req;
+    req.fd = fd;
+    req.offset = offsetOf(pids[i]);
+    req.buffer = pages[i];
+    req.length = PAGE_SIZE;
+    reqs.push_back(req);
   }
 
-  // seek to the page
-  if ((rc = seek(pid) < 0)) return rc;
-  
-  // find the cache slot to evict
-  int toEvict = 0; 
-  for (int i = 0; i < CACHE_COUNT; i++) {
-    if (readCache[i].lastAccessed == 0) {
-      toEvict = i;
-      break;
-    }
-    if (readCache[i].lastAccessed < readCache[toEvict].lastAccessed) {
-      toEvict = i;
+  // one batch at a time goes through the shared submission queue
+  if (!reqs.empty()) {
+    std::lock_guard<std::mutex> guard(latch);
+    long long start = FileStats::now();
+    if ((rc = io->readAll(&reqs[0], (int)reqs.size())) < 0) return rc;
+    stats->recordRead((int)reqs.size(), (long long)reqs.size() * PAGE_SIZE, start);
+  }
+
+  // the rest of a page read short comes after the batch
+  for (unsigned i = 0; i < reqs.size(); i++) {
+    if ((size_t)reqs[i].result >= reqs[i].length) continue;
+    struct iovec rest = { reqs[i].buffer + reqs[i].result, reqs[i].length - reqs[i].result };
+    if (readFully(fd, &rest, 1, reqs[i].offset + reqs[i].result) < 0) return RC_FILE_READ_FAILED;
+  }
+
+  // increase the page read count
+  readCount += n;
+
+  return 0;
+}
+
+RC PageFile::prefetch(const std::vector<PageId>& pids) const
+{
+  std::vector<PageId> valid;
+
+  for (unsigned i = 0; i < pids.size(); i++) {
+    if (pids[i] >= 0 && pids[i] < epid) valid.push_back(pids[i]);
+  }
+  if (valid.empty()) return 0;
+
+  // the kernel pages a mapping in by itself; just tell it what is coming
+  if (map != NULL) {
+    for (unsigned i = 0; i < valid.size(); i++) {
+      ::madvise(map + offsetOf(valid[i]), PAGE_SIZE, MADV_WILLNEED);
     }
+    return 0;
   }
-  readCache[toEvict].fd = fd;
-  readCache[toEvict].pid = pid;
-  readCache[toEvict].lastAccessed = ++cacheClock;
- 
-  // read the page to cache first and copy it to the buffer
-  if (::read(fd, readCache[toEvict].buffer, PAGE_SIZE) < 0) {
-    return RC_FILE_READ_FAILED;
+
+  return cache.prefetch(fid, &valid[0], (int)valid.size(), this);
+}
+
+RC PageFile::prewarm(const std::vector<PageId>& pids) const
+{
+  RC rc;
+  std::vector<PageId> sorted(pids);
+  size_t batch = std::max(1, cache.frameCount() / 2);
+
+  // read in pid order, so that neighbouring pages are read together
+  std::sort(sorted.begin(), sorted.end());
+  sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+  if (sorted.size() > (size_t)cache.frameCount()) sorted.resize(cache.frameCount());
+
+  // prefetch() claims at most half of the cache at a time
+  for (size_t i = 0; i < sorted.size(); i += batch) {
+    std::vector<PageId> chunk(sorted.begin() + i, sorted.begin() + std::min(i + batch, sorted.size()));
+    if ((rc = prefetch(chunk)) < 0) return rc;
+  }
+  return 0;
+}
+
+void PageFile::extendTo(PageId pid)
+{
+  // if the written pid >= end pid, update the end pid.
+  // other threads may be extending the file at the same time
+  PageId end = epid;
+  while (pid >= end && !epid.compare_exchange_weak(end, pid + 1)) { }
+}
+
+RC PageFile::loadPageMap(bool create)
+{
+  int  header[2];
+  long long sizes[2];
+  int  mfd;
+
+  slots.clear();
+  dataEnd = 0;
+  freeSpace.clear();
+  freedSlots.clear();
+
+  // a new file starts with an empty page map
+  if (create) {
+    version = FORMAT_VERSION;
+    slotsDirty = true;
+    epid = 0;
+    return 0;
+  }
+
+  // the page map is a header (magic, page size, # of pages, end of the
+  // stored pages) followed by the slot of every page. the magic tells
+  // the format version of the file
+  if ((mfd = ::open(mapName.c_str(), O_RDONLY)) < 0) return RC_FILE_OPEN_FAILED;
+  if (::pread(mfd, header, sizeof(header), 0) != sizeof(header) ||
+      ::pread(mfd, sizes, sizeof(sizes), sizeof(header)) != sizeof(sizes) ||
+      (header[0] != PAGE_MAP_MAGIC && header[0] != PAGE_MAP_MAGIC_V2 && header[0] != PAGE_MAP_MAGIC_V1) ||
+      header[1] != PAGE_SIZE || sizes[0] < 0) {
+    ::close(mfd);
+    return RC_INVALID_FILE_FORMAT;
+  }
+
+  slots.resize(sizes[0]);
+  ssize_t bytes = (ssize_t)(slots.size() * sizeof(PageSlot));
+  if (bytes > 0 && ::pread(mfd, &slots[0], bytes, sizeof(header) + sizeof(sizes)) != bytes) {
+    ::close(mfd);
+    slots.clear();
+    return RC_INVALID_FILE_FORMAT;
+  }
+  ::close(mfd);
+
+  version = (header[0] == PAGE_MAP_MAGIC) ? FORMAT_VERSION : (header[0] == PAGE_MAP_MAGIC_V2) ? 2 : 1;
+  dataEnd = sizes[1];
+  slotsDirty = false;
+  epid = (PageId)slots.size();
+
+  // the space between the slots, left by pages that moved, can be reused
+  std::vector<std::pair<long long, int> > used;
+  for (unsigned i = 0; i < slots.size(); i++) {
+    if (slots[i].capacity > 0) used.push_back(std::make_pair(slots[i].offset, slots[i].capacity));
+  }
+  std::sort(used.begin(), used.end());
+  long long end = 0;
+  for (unsigned i = 0; i < used.size(); i++) {
+    if (used[i].first > end) freeSpace.insert(std::make_pair(used[i].first - end, end));
+    end = std::max(end, used[i].first + used[i].second);
+  }
+  if (dataEnd > end) freeSpace.insert(std::make_pair(dataEnd - end, end));
+
+  return 0;
+}
+
+RC PageFile::savePageMap()
+{
+  int  header[2] = { version >= 3 ? PAGE_MAP_MAGIC : version == 2 ? PAGE_MAP_MAGIC_V2 : PAGE_MAP_MAGIC_V1, PAGE_SIZE };
+  long long sizes[2];
+  std::vector<char> out;
+  RC   rc;
+  std::lock_guard<std::mutex> guard(slotLatch);
+
+  if (!slotsDirty || !mapWrite) return 0;
+
+  // while page writes are logged, the map is made durable, and it may
+  // only point to pages that are on disk
+  bool sync = WriteAheadLog::isOpen();
+  if (sync && ::fdatasync(fd) < 0) return RC_FILE_WRITE_FAILED;
+
+  // rewrite the whole map; it is small compared to the file
+  sizes[0] = (long long)slots.size();
+  sizes[1] = dataEnd;
+  out.resize(sizeof(header) + sizeof(sizes) + slots.size() * sizeof(PageSlot));
+  memcpy(&out[0], header, sizeof(header));
+  memcpy(&out[sizeof(header)], sizes, sizeof(sizes));
+  if (!slots.empty()) memcpy(&out[sizeof(header) + sizeof(sizes)], &slots[0], slots.size() * sizeof(PageSlot));
+  if ((rc = replaceFile(mapName, &out[0], out.size(), sync)) < 0) return rc;
+
+  // no saved map points to the slots left by moved pages any more
+  for (unsigned i = 0; i < freedSlots.size(); i++) {
+    freeSpace.insert(std::make_pair((long long)freedSlots[i].second, freedSlots[i].first));
+  }
+  freedSlots.clear();
+
+  slotsDirty = false;
+  return 0;
+}
+
+long long PageFile::allocateSlot(int capacity)
+{
+  long long offset;
+
+  // the smallest free space that fits, or the end of the stored pages
+  std::multimap<long long, long long>::iterator it = freeSpace.lower_bound(capacity);
+  if (it == freeSpace.end()) {
+    offset = dataEnd;
+    dataEnd += capacity;
+    return offset;
+  }
+
+  offset = it->second;
+  long long rest = it->first - capacity;
+  freeSpace.erase(it);
+  if (rest > 0) freeSpace.insert(std::make_pair(rest, offset + capacity));
+  return offset;
+}
+
+RC PageFile::readCompressed(PageId pid, char* page) const
+{
+  char     buf[PAGE_SIZE];
+  PageSlot slot = { 0, 0, 0 };
+
+  {
+    std::lock_guard<std::mutex> guard(slotLatch);
+    if (pid < (PageId)slots.size()) slot = slots[pid];
+  }
+
+  if (slot.length == 0) {
+    // the page was never written
+    memset(page, 0, PAGE_SIZE);
+  } else if (slot.length == PAGE_SIZE) {
+    // the page did not compress
+    long long start = FileStats::now();
+    if (::pread(fd, page, PAGE_SIZE, slot.offset) != PAGE_SIZE) return RC_FILE_READ_FAILED;
+    stats->recordRead(1, PAGE_SIZE, start);
+  } else {
+    long long start = FileStats::now();
+    if (::pread(fd, buf, slot.length, slot.offset) != slot.length) return RC_FILE_READ_FAILED;
+    stats->recordRead(1, slot.length, start);
+    if (LZCodec::decompress(buf, slot.length, page, PAGE_SIZE) != PAGE_SIZE) return RC_FILE_READ_FAILED;
   }
-  memcpy(buffer, readCache[toEvict].buffer, PAGE_SIZE);
 
   // increase the page read count
   readCount++;
 
   return 0;
 }
+
+RC PageFile::writeCompressed(PageId pid, const char* page)
+{
+  char        buf[PAGE_SIZE];
+  const char* data = buf;
+  long long   offset;
+
+  // store the page as is if compressing does not save anything
+  int length = LZCodec::compress(page, PAGE_SIZE, buf, PAGE_SIZE - 1);
+  if (length < 0) {
+    length = PAGE_SIZE;
+    data = page;
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(slotLatch);
+    if (pid >= (PageId)slots.size()) {
+      PageSlot unused = { 0, 0, 0 };
+      slots.resize(pid + 1, unused);
+    }
+
+    // a page that outgrew its slot moves to a slot at least twice as large,
+    // so that a growing page moves rarely. the old slot is reused once the
+    // page map that no longer points to it is saved
+    PageSlot& slot = slots[pid];
+    if (length > slot.capacity) {
+      int capacity = (length + SLOT_ALIGNMENT - 1) / SLOT_ALIGNMENT * SLOT_ALIGNMENT;
+      capacity = std::min(PAGE_SIZE, std::max(capacity, 2 * slot.capacity));
+      if (slot.capacity > 0) freedSlots.push_back(std::make_pair(slot.offset, slot.capacity));
+      slot.offset = allocateSlot(capacity);
+      slot.capacity = capacity;
+    }
+    slot.length = length;
+    offset = slot.offset;
+    slotsDirty = true;
+  }
+
+  long long start = FileStats::now();
+  if (::pwrite(fd, data, length, offset) != length) return RC_FILE_WRITE_FAILED;
+  stats->recordWrite(1, length, start);
+
+  return 0;
+}
+
+RC PageFile::reserve(PageId pid, int n)
+{
+  if (fd < 0 || !mapWrite) return RC_FILE_WRITE_FAILED;
+  if (pid < 0 || n <= 0) return RC_INVALID_PID;
+
+  // a mapping is grown by growMap(), and compressed pages have no fixed place
+  if (flags & (MMAP | COMPRESS)) return 0;
+
+#ifdef FALLOC_FL_KEEP_SIZE
+  // keep the file size, so that the reserved pages do not count as written
+  if (::fallocate(fd, FALLOC_FL_KEEP_SIZE, offsetOf(pid), (off_t)n * PAGE_SIZE) < 0 &&
+      errno != EOPNOTSUPP && errno != ENOSYS) {
+    return RC_FILE_WRITE_FAILED;
+  }
+#endif
+
+  return 0;
+}
+
+RC PageFile::setAccessPattern(AccessPattern pattern)
+{
+  int advice, fadvice;
+
+  switch (pattern) {
+  case SEQUENTIAL: advice = MADV_SEQUENTIAL; fadvice = POSIX_FADV_SEQUENTIAL; break;
+  case RANDOM:     advice = MADV_RANDOM;     fadvice = POSIX_FADV_RANDOM;     break;
+  default:         advice = MADV_NORMAL;     fadvice = POSIX_FADV_NORMAL;     break;
+  }
+
+  if (map != NULL) {
+    if (mapSize > 0 && ::madvise(map, mapSize, advice) < 0) return RC_INVALID_ATTRIBUTE;
+  } else if (fd >= 0) {
+    if (::posix_fadvise(fd, 0, 0, fadvice) != 0) return RC_INVALID_ATTRIBUTE;
+  }
+
+  std::lock_guard<std::mutex> guard(raLatch);
+  this->pattern = pattern;
+
+  return 0;
+}
+
+void PageFile::resetReadAhead()
+{
+  pattern = NORMAL;
+  raLast = -1;
+  raRun = 0;
+  raWindow = MIN_READAHEAD;
+  raEnd = 0;
+}
+
+void PageFile::readAhead(PageId pid) const
+{
+  PageId first;
+  int    count;
+  int    next;
+
+  {
+    std::lock_guard<std::mutex> guard(raLatch);
+
+    // several records of a page are read one after the other
+    if (pattern == RANDOM || pid == raLast) return;
+
+    // a jump ends the run and shrinks the window back
+    if (pid != raLast + 1) {
+      raLast = pid;
+      raRun = 0;
+      raWindow = MIN_READAHEAD;
+      raEnd = pid + 1;
+      return;
+    }
+    raLast = pid;
+
+    // a scan announced as sequential is read ahead right away
+    if (++raRun < READAHEAD_TRIGGER && pattern != SEQUENTIAL) return;
+
+    // a window larger than the cache would evict itself before being read
+    int window = std::min(raWindow, std::max(1, cache.frameCount() / 4));
+
+    // start on the next window once the reader is half way through this one
+    if (raEnd - pid > window / 2) return;
+
+    first = std::max(raEnd, pid + 1);
+    count = (int)std::min((PageId)window, epid - first);
+    if (count <= 0) return;
+
+    raEnd = first + count;
+    if (raWindow < MAX_READAHEAD) raWindow *= 2;
+    next = raWindow;
+  }
+
+  // read the window into the cache with large reads, and ask the kernel
+  // to start reading the window after it meanwhile
+  std::vector<PageId> pids(count);
+  for (int i = 0; i < count; i++) pids[i] = first + i;
+  cache.prefetch(fid, &pids[0], count, this);
+
+  ::posix_fadvise(fd, offsetOf(first + count), (off_t)next * PAGE_SIZE, POSIX_FADV_WILLNEED);
+}
+
+RC PageFile::mapFile()
+{
+  // a read-only mapping covers the file as it is when opened
+  if (!mapWrite) {
+    if (epid == 0) return 0;
+    mapSize = (size_t)offsetOf(epid);
+
+    void* addr = ::mmap(NULL, mapSize, PROT_READ, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) { mapSize = 0; return RC_FILE_OPEN_FAILED; }
+
+    map = (char*)addr;
+    return 0;
+  }
+
+  // a writable mapping reserves address space for the file to grow into.
+  // the file is mapped over the start of the reservation, piece by piece
+  void* addr = ::mmap(NULL, MMAP_RESERVE, PROT_NONE,
+                      MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+  if (addr == MAP_FAILED) return RC_OUT_OF_MEMORY;
+  map = (char*)addr;
+  mapSize = 0;
+
+  return (epid > 0) ? growMap(epid - 1) : 0;
+}
+
+RC PageFile::growMap(PageId pid)
+{
+  std::lock_guard<std::mutex> guard(mapLatch);
+
+  size_t need = (size_t)offsetOf(pid + 1);
+  if (need <= mapSize) return 0;
+  if (need > MMAP_RESERVE) return RC_FILE_WRITE_FAILED;
+
+  // grow by at least a factor of two to amortize the remapping. the next
+  // piece is mapped at the end of this one, so that end must fall on a
+  // boundary of the OS pages even if the file does not
+  size_t osPage = (size_t)::sysconf(_SC_PAGESIZE);
+  size_t size = std::max(need, std::max(2 * mapSize, (size_t)64 * PAGE_SIZE));
+  size = std::min((size + osPage - 1) / osPage * osPage, MMAP_RESERVE);
+
+  // the file must be as large as its mapping. the slack after the last
+  // page is cut off again in unmapFile()
+  struct stat statbuf;
+  if (::fstat(fd, &statbuf) < 0) return RC_FILE_WRITE_FAILED;
+  if ((size_t)statbuf.st_size < size && ::ftruncate(fd, size) < 0) {
+    return RC_FILE_WRITE_FAILED;
+  }
+
+  void* addr = ::mmap(map + mapSize, size - mapSize, PROT_READ|PROT_WRITE,
+                      MAP_SHARED|MAP_FIXED, fd, mapSize);
+  if (addr == MAP_FAILED) return RC_FILE_WRITE_FAILED;
+
+  mapSize = size;
+  return 0;
+}
+
+RC PageFile::unmapFile()
+{
+  RC rc = 0;
+
+  if (mapWrite) {
+    // write back the mapped pages and drop the slack at the end of the file
+    if (mapSize > 0 && ::msync(map, mapSize, MS_SYNC) < 0) rc = RC_FILE_WRITE_FAILED;
+    if (::munmap(map, MMAP_RESERVE) < 0) rc = RC_FILE_CLOSE_FAILED;
+    if (::ftruncate(fd, offsetOf(epid)) < 0) rc = RC_FILE_WRITE_FAILED;
+  } else if (mapSize > 0) {
+    if (::munmap(map, mapSize) < 0) rc = RC_FILE_CLOSE_FAILED;
+  }
+
+  map = NULL;
+  mapSize = 0;
+  return rc;
+}
+
+RC PageFile::write(PageId pid, const void* buffer)
+{
+  RC rc;
+  if (pid < 0) return RC_INVALID_PID; 
+
+  PageTrace::record(fid, pid, PageTrace::WRITE);
+
+  if (map != NULL || (flags & MMAP)) {
+    // copy the buffer into the mapping, extending it if necessary
+    if (!mapWrite) return RC_FILE_WRITE_FAILED;
+    if ((rc = growMap(pid)) < 0) return rc;
+    memcpy(map + offsetOf(pid), buffer, PAGE_SIZE);
+  } else if (flags & WRITE_BACK) {
+    // only update the cached page; it is written to disk later
+    if ((rc = cache.write(fid, pid, buffer)) < 0) return rc;
+    extendTo(pid);
+    return WriteAheadLog::isOpen() ? WriteAheadLog::append(name, pid, (const char*)buffer) : 0;
+  } else {
+    // O_DIRECT transfers need an aligned buffer
+    if (flags & DIRECT) {
+      alignas(BufferPool::FRAME_ALIGNMENT) static thread_local char aligned[PAGE_SIZE];
+      memcpy(aligned, buffer, PAGE_SIZE);
+      buffer = aligned;
+    }
+
+    // write the buffer to the disk page
+    if (flags & COMPRESS) {
+      if ((rc = writeCompressed(pid, (const char*)buffer)) < 0) return rc;
+    } else {
+      long long start = FileStats::now();
+      if (::pwrite(fd, buffer, PAGE_SIZE, offsetOf(pid)) < 0) return RC_FILE_WRITE_FAILED;
+      stats->recordWrite(1, PAGE_SIZE, start);
+    }
+  }
+
+  // if the page is in the cache, keep the cached copy up to date
+  cache.update(fid, pid, buffer);
+
+  extendTo(pid);
+
+  // increase page write count
+  writeCount++;
+
+  // log the page once it is written, so that it survives a crash
+  return WriteAheadLog::isOpen() ? WriteAheadLog::append(name, pid, (const char*)buffer) : 0;
+}
+
+RC PageFile::read(PageId pid, void* buffer) const
+{
+  RC rc;
+  const char* page;
+
+  // read the page through the cache and copy it to the buffer
+  if ((rc = pin(pid, page)) < 0) return rc;
+  memcpy(buffer, page, PAGE_SIZE);
+  unpin(page);
+
+  return 0;
+}
+
+RC PageFile::pin(PageId pid, const char*& page) const
+{
+  RC rc;
+  char* frame;
+
+  if (pid < 0 || pid >= epid) return RC_INVALID_PID; 
+
+  PageTrace::record(fid, pid, PageTrace::READ);
+
+  // a mapped page is served straight from the mapping
+  if (map != NULL) {
+    page = map + offsetOf(pid);
+    return 0;
+  }
+
+  // keep the pages after it coming if the file is read in order
+  readAhead(pid);
+
+  // pin the page in the cache, reading it from disk if it is not cached
+  if ((rc = cache.pin(fid, pid, this, frame)) < 0) return rc;
+  page = frame;
+
+  return 0;
+}
+
+void PageFile::unpin(const char* page) const
+{
+  // mapped pages are not pinned in the cache
+  if (map == NULL) cache.unpin(page);
+}
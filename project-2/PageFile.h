@@ -11,23 +11,74 @@
 #define PAGEFILE_H
 
 #include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <atomic>
+#include <mutex>
 #include "Bruinbase.h"
+#include "BufferPool.h"
+#include "IOStats.h"
 
-typedef int PageId;
+// the size of a page in bytes. the default of 1KB can be changed at compile
+// time (e.g., -DBRUINBASE_PAGE_SIZE=8192; see the bruinbase-8k make target).
+// files written with one page size cannot be read with another
+#ifndef BRUINBASE_PAGE_SIZE
+#define BRUINBASE_PAGE_SIZE 1024
+#endif
 
 /**
- * read/write a file in the unit of a page
+ * read/write a file in the unit of a page.
+ * pages of a file may be read and written from several threads at once:
+ * disk I/O uses pread()/pwrite() and never moves a shared file cursor.
+ * pages of a mapped file (MMAP flag) are not latched, so a reader of a
+ * mapped page may see a concurrent write to it halfway done.
+ * open() and close() must not race with any other call on the same object.
  */
-class PageFile {
+class PageFile : public PageStore {
  public:
 
-  static const int PAGE_SIZE = 1024;    // the size of a page is 1KB
+  static const int PAGE_SIZE = BRUINBASE_PAGE_SIZE;
+  static_assert(PAGE_SIZE >= 1024 && PAGE_SIZE <= 65536 && (PAGE_SIZE & (PAGE_SIZE - 1)) == 0,
+                "the page size must be a power of two between 1KB and 64KB");
+
+  //
+  // flags for open(). they select how pages are moved between disk and memory
+  //
+  static const int MMAP = 0x1;  // serve pages from a memory mapping of the file
+                                // instead of the page cache. writes in 'w' mode
+                                // go to the mapping and are msync'ed on close()
+  static const int WRITE_BACK = 0x2; // keep written pages in the page cache and
+                                // write them to disk on eviction, flush() or close()
+  static const int DIRECT = 0x4; // bypass the OS page cache (O_DIRECT), so that the
+                                // page cache is the only one. ignored with MMAP, on
+                                // file systems that do not support O_DIRECT, and on
+                                // devices whose blocks are larger than the pages
+  static const int COMPRESS = 0x8; // store the pages of a new file compressed. where
+                                // each page is stored is kept in a page map file
+                                // (filename + ".map"), whose presence marks the file
+                                // as compressed on later opens. ignores MMAP and DIRECT
+
+  // the format written by this build. files of version 2 start with a header
+  // page holding the version and the page size, and may hold 64-bit page ids.
+  // version 3 tables store variable-length records in slotted pages (see
+  // RecordFile). version 1 files (no header page, 32-bit page ids) and
+  // version 2 files can still be read
+  static const int FORMAT_VERSION = 3;
+
+  // files grow by extents of this many pages (256KB, at least 8 pages)
+  static const int EXTENT_PAGES = (256 * 1024 / PAGE_SIZE < 8) ? 8 : 256 * 1024 / PAGE_SIZE;
+
+  // hints on how the pages of a file are going to be accessed
+  enum AccessPattern { NORMAL, SEQUENTIAL, RANDOM };
 
   PageFile();
   PageFile(const std::string& filename, char mode);
+  ~PageFile();
 
   /**
-   * open a file in read or write mode.
+   * open a file in read or write mode, with the default flags
+   * (see setDefaultFlags()).
    * when opened in 'w' mode, if the file does not exist, it is created.
    * @param filename[IN] the name of the file to open
    * @param mode[IN] 'r' for read, 'w' for write
@@ -36,10 +87,27 @@ class PageFile {
   RC open(const std::string& filename, char mode);
 
   /**
-   * close the file.
+   * open a file in read or write mode.
+   * when opened in 'w' mode, if the file does not exist, it is created.
+   * @param filename[IN] the name of the file to open
+   * @param mode[IN] 'r' for read, 'w' for write
+   * @param flags[IN] a combination of the open flags (e.g., MMAP)
+   * @return error code. 0 if no error
+   */
+  RC open(const std::string& filename, char mode, int flags);
+
+  /**
+   * close the file. pages written in WRITE_BACK mode are flushed first.
    * @return error code. 0 if no error
    */
   RC close();
+
+  /**
+   * write every page modified in WRITE_BACK mode to disk.
+   * runs of consecutive pages are written with a single request.
+   * @return error code. 0 if no error
+   */
+  RC flush();
   
   /**
    * read a disk page into memory buffer.
@@ -48,11 +116,47 @@ class PageFile {
    * @return error code. 0 if no error
    */
   RC read(PageId pid, void *buffer) const;
+
+  /**
+   * pin a disk page in the page cache and return a pointer to the
+   * cached copy. unlike read(), no copy of the page is made.
+   * the page stays in the cache until it is unpinned; prefer PinnedPage,
+   * which unpins automatically, to calling this function directly.
+   * @param pid[IN] the page to pin
+   * @param page[OUT] the cached content of the page
+   * @return error code. 0 if no error
+   */
+  RC pin(PageId pid, const char*& page) const;
+
+  /**
+   * read pages into the page cache ahead of their use. the reads are
+   * submitted as one batch (see AsyncIO), so they are in flight together
+   * rather than one after the other. pages already cached are skipped.
+   * @param pids[IN] the pages that are going to be read
+   * @return error code. 0 if no error
+   */
+  RC prefetch(const std::vector<PageId>& pids) const;
+
+  /**
+   * read a set of pages into the page cache in pid order, in batches as
+   * large as the cache admits. pages beyond the capacity of the cache
+   * are left out.
+   * @param pids[IN] the pages to read, in any order
+   * @return error code. 0 if no error
+   */
+  RC prewarm(const std::vector<PageId>& pids) const;
+
+  /**
+   * release a page pinned by pin().
+   * @param page[IN] the pointer returned by pin()
+   */
+  void unpin(const char* page) const;
   
   /**
    * write the memory buffer to the disk page.
    * if (pid >= endPid()), the file is expanded such that
    * endPid() becomes (pid + 1).
+   * in WRITE_BACK mode, the page is only written to the page cache.
    * @param pid[IN] page to write to
    * @param buffer[IN] the content to write
    * @return error code. 0 if no error
@@ -67,46 +171,313 @@ class PageFile {
   PageId endPid() const;
 
   /**
-   * @return the total # of disk reads
+   * reserve disk space for n pages starting at page pid, so that later
+   * writes to them need not allocate blocks one page at a time and the
+   * pages end up contiguous on disk. endPid() does not change.
+   * this is only a hint: nothing is done for mapped or compressed files,
+   * or on file systems that cannot reserve space (see fallocate(2)).
+   * @param pid[IN] the first page to reserve
+   * @param n[IN] the number of pages
+   * @return error code. 0 if no error
    */
-  static int getPageReadCount()  { return readCount; }
-  
+  RC reserve(PageId pid, int n);
+
+  /**
+   * tell the kernel, and the read-ahead of the page cache, how the pages
+   * of the file are going to be accessed. even with the NORMAL pattern,
+   * a run of reads of consecutive pages is detected and read ahead.
+   * @param pattern[IN] the expected access pattern
+   * @return error code. 0 if no error
+   */
+  RC setAccessPattern(AccessPattern pattern);
+
+  /**
+   * set the flags used by open() when no flags are given.
+   * @param flags[IN] a combination of the open flags
+   */
+  static void setDefaultFlags(int flags) { defaultFlags = flags; }
+
+  /**
+   * @return the flags the file was opened with. DIRECT is cleared if the
+   *   file could not be read with it
+   */
+  int getFlags() const { return flags; }
+
+  /**
+   * @return the format version of the file (see FORMAT_VERSION)
+   */
+  int getFormatVersion() const { return version; }
+
+  /**
+   * @return the total # of disk reads. pages of a mapped file are faulted
+   *   in by the kernel and are not counted
+   */
+  static long long getPageReadCount()  { return readCount; }
+
   /**
    * @return the total # of disk writes
+   *   (pages written back from the page cache included)
+   */
+  static long long getPageWriteCount() { return writeCount; }
+
+  /**
+   * resize the page cache shared by all PageFiles.
+   * every cached page is dropped.
+   * @param bytes[IN] the cache capacity, rounded down to whole pages
+   * @return error code. 0 if no error
+   */
+  static RC setCacheSize(size_t bytes);
+
+  /**
+   * select the replacement policy of the page cache.
+   * every cached page is dropped.
+   * @param policy[IN] "lru" or "clock"
+   * @return error code. 0 if no error
+   */
+  static RC setCachePolicy(const std::string& policy);
+
+  /**
+   * write back every dirty page and drop every page of the page cache,
+   * so that the following reads go to disk. no page may be pinned.
+   * note that without the DIRECT flag the pages may still be read from
+   * the OS page cache.
+   * @return error code. 0 if no error
+   */
+  static RC dropCache() { return cache.dropAll(); }
+
+  /**
+   * flush() every open file, e.g., before the files are synced to disk.
+   * @return error code. 0 if no error
    */
-  static int getPageWriteCount() { return writeCount; }
+  static RC flushOpenFiles();
 
- protected:
   /**
-   * move the file cursor to the beginning of a page.
-   * this is an internal function not exposed to public.
-   * @param pid[IN] page to seek to
+   * save the page map of every open compressed file whose pages moved
+   * since it was last saved. WriteAheadLog::commit() calls it, so that
+   * the pages it makes durable can be found after a crash.
    * @return error code. 0 if no error
    */
-  RC seek(PageId pid) const;
+  static RC savePageMaps();
+
+  /**
+   * replace the content of a file with data, so that a crash leaves
+   * either the old or the new content: data is written to a temporary
+   * file that is then renamed over the file.
+   * @param path[IN] the file to replace
+   * @param data[IN] the new content
+   * @param length[IN] the # of bytes of data
+   * @param sync[IN] true to have the new content on disk on return
+   * @return error code. 0 if no error
+   */
+  static RC replaceFile(const std::string& path, const void* data, size_t length, bool sync);
+
+  /**
+   * sync the directory holding a file, so that its creation, removal or
+   * renaming survives a crash.
+   * @param path[IN] the file
+   * @return error code. 0 if no error
+   */
+  static RC syncDirectory(const std::string& path);
+
+  /**
+   * record which pages of which files the page cache holds, so that a
+   * later process can read them back with loadCache().
+   * @param path[IN] the file to write the list to (see CACHE_FILE)
+   * @return error code. 0 if no error
+   */
+  static RC saveCache(const std::string& path);
+
+  /**
+   * read the pages recorded by saveCache() back into the page cache.
+   * the pages of each file are read with prewarm(). files that no longer
+   * exist are skipped, and so are pages beyond the end of their file.
+   * @param path[IN] the file written by saveCache()
+   * @return error code. RC_FILE_OPEN_FAILED if there is no such file
+   */
+  static RC loadCache(const std::string& path);
+
+  // where the contents of the page cache are recorded across restarts
+  static const char* const CACHE_FILE;
+
+  /**
+   * @return the capacity of the page cache in bytes
+   */
+  static size_t getCacheSize() { return (size_t)cache.frameCount() * PAGE_SIZE; }
+
+  /**
+   * @return the name of the replacement policy of the page cache
+   */
+  static const char* getCachePolicy() { return cache.policyName(); }
+
+  /**
+   * @param fid[IN] the page cache id of a file (see FileStats::list())
+   * @return what the page cache did for the pages of the file
+   */
+  static BufferPool::FileCounters getCacheCounters(int fid) { return cache.getFileCounters(fid); }
+
+  /**
+   * @return the total # of page reads served from the cache
+   */
+  static long long getCacheHitCount()  { return cache.getHitCount(); }
+
+  /**
+   * @return the total # of page reads that missed the cache
+   */
+  static long long getCacheMissCount() { return cache.getMissCount(); }
 
  private:
+  std::string name; // the name the file was opened with
   int     fd;     // file descriptor of the associated unix file
-  PageId  epid;   // (last page id + 1) of the file
+  int     fid;    // id of the file in the page cache
+  std::atomic<PageId> epid; // (last page id + 1) of the file
+  int     flags;  // the open flags of the file
+  FileStats* stats; // the I/O counters of the file
+  int     version; // the format version of the file
+  int     base;    // # of header pages in front of page 0
+
+  static const int FILE_MAGIC = 0x46424242; // "BBBF"
+
+  // the header page of a version 2 or later file
+  struct FileHeader {
+    int magic;    // FILE_MAGIC
+    int version;  // the format version
+    int pageSize; // PAGE_SIZE of the build that created the file
+  };
+
+  RC readHeader(const std::string& filename, long long size, bool create);
+
+  // where page pid is stored in the file
+  long long offsetOf(PageId pid) const { return (pid + base) * (long long)PAGE_SIZE; }
+
+  //
+  // memory mapping of the file (MMAP flag)
+  //
+  char*   map;      // the start of the mapping
+  size_t  mapSize;  // # of bytes of the file that are mapped
+  bool    mapWrite; // whether the mapping is writable
+  std::mutex mapLatch; // serializes growing the mapping
+
+  //
+  // compressed pages (COMPRESS flag). pages are stored with variable sizes
+  // wherever there is room for them, and found through the page map
+  //
+  struct PageSlot {
+    long long offset;   // where the page is stored
+    int       length;   // # of bytes stored: 0 if the page was never written,
+                        // PAGE_SIZE if it is stored uncompressed
+    int       capacity; // # of bytes reserved at offset
+  };
+  std::string mapName;          // the name of the page map file
+  std::vector<PageSlot> slots;  // where each page is stored
+  long long  dataEnd;           // the end of the stored pages
+  std::multimap<long long, long long> freeSpace; // # of bytes -> offset of the
+                                // space between the slots that can be reused
+  std::vector<std::pair<long long, int> > freedSlots; // (offset, capacity) of the
+                                // slots left by moved pages, which the saved page
+                                // map may still point to
+  bool       slotsDirty;        // whether slots differ from the page map file
+  mutable std::mutex slotLatch; // protects the members above
+
+  static const int SLOT_ALIGNMENT = 64; // slots are reserved in multiples of this
+  static const int PAGE_MAP_MAGIC = 0x33504242;    // "BBP3": a version 3 file
+  static const int PAGE_MAP_MAGIC_V2 = 0x32504242; // "BBP2": a version 2 file
+  static const int PAGE_MAP_MAGIC_V1 = 0x4d504242; // "BBPM": a version 1 file
+
+  RC loadPageMap(bool create);
+  RC savePageMap();
+  long long allocateSlot(int capacity);
+  RC readCompressed(PageId pid, char* page) const;
+  RC writeCompressed(PageId pid, const char* page);
 
   //
-  // the following set of members implement LRU caching 
+  // sequential read-ahead into the page cache
   //
-  static const int CACHE_COUNT = 10;
+  AccessPattern pattern;     // the access pattern announced by the user
+  mutable PageId raLast;     // the page pinned last
+  mutable int    raRun;      // # of consecutive pages pinned in a row
+  mutable int    raWindow;   // # of pages to read ahead next time
+  mutable PageId raEnd;      // the first page not read ahead yet
+  mutable std::mutex raLatch; // protects the read-ahead state
+
+  static const int READAHEAD_TRIGGER = 4;  // consecutive pages before reading ahead
+  static const int MIN_READAHEAD = (8 * 1024 > PAGE_SIZE) ? 8 * 1024 / PAGE_SIZE : 1;
+                                           // the first read-ahead window (8KB), in pages
+  static const int MAX_READAHEAD = 256 * 1024 / PAGE_SIZE; // the window doubles up to 256KB
+
+  // a writable mapping reserves this much address space up front,
+  // so that pages never move as the file grows
+  static const size_t MMAP_RESERVE = (size_t)1 << 36; // 64GB
+
+  RC readPage(PageId pid, char* page) const;
+  RC readPages(const PageId* pids, char* const* pages, int n) const;
+  RC writePages(PageId pid, const char* const* pages, int n);
+  void extendTo(PageId pid);
+  void readAhead(PageId pid) const;
+  void resetReadAhead();
+
+  RC mapFile();
+  RC growMap(PageId pid);
+  RC unmapFile();
+
+  static int defaultFlags; // flags used by open(filename, mode)
+
+  static std::set<PageFile*> openFiles; // every open file
+  static std::mutex openLatch;          // protects openFiles
+
+  static const size_t DEFAULT_CACHE_SIZE = 4*1024*1024; // 4MB
+
+  static const int PREFETCH_DEPTH = 64; // max # of prefetch reads in flight
 
-  static int cacheClock; // clock tick counter for LRU policy
+  // the page cache shared by all files. pages are cached by the identity
+  // of the underlying unix file, so they stay cached after close()
+  static BufferPool cache;
 
-  // the actual cache data structure
-  static struct cacheStruct {
-    int    fd;              // file id of the cached page
-    PageId pid;             // page id of the cached page
-    int    lastAccessed;    // the last time the cached page was accessed
-                            //   (lastAccessed == 0) means that the buffer is empty
-    char buffer[PAGE_SIZE]; // the buffer used for caching
-  } readCache[CACHE_COUNT];
+  static std::atomic<long long> readCount;  // total # of page reads
+  static std::atomic<long long> writeCount; // total # of page writes
+};
+
+/**
+ * a page pinned in the page cache for as long as the object lives.
+ * the content is read in place: page bytes are not copied.
+ */
+class PinnedPage {
+ public:
+  PinnedPage() : pf(NULL), page(NULL) {}
+  ~PinnedPage() { release(); }
+
+  /**
+   * pin a page, releasing the page held before (if any).
+   * @param pf[IN] the file to read from
+   * @param pid[IN] the page to pin
+   * @return error code. 0 if no error
+   */
+  RC pin(const PageFile& pf, PageId pid) {
+    release();
+    RC rc = pf.pin(pid, page);
+    if (rc == 0) this->pf = &pf;
+    return rc;
+  }
+
+  /**
+   * unpin the page held, if any.
+   */
+  void release() {
+    if (page != NULL) pf->unpin(page);
+    pf = NULL;
+    page = NULL;
+  }
+
+  /**
+   * @return the content of the pinned page
+   */
+  const char* data() const { return page; }
+
+ private:
+  PinnedPage(const PinnedPage&);            // not copyable
+  PinnedPage& operator=(const PinnedPage&);
 
-  static int readCount;  // total # of page reads 
-  static int writeCount; // total # of page writes 
+  const PageFile* pf;
+  const char*     page;
 };
   
 #endif // PAGEFILE_H
@@ -0,0 +1,114 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/17/2026
+ */
+
+#include "PageTrace.h"
+
+using std::string;
+using std::vector;
+
+std::atomic<bool> PageTrace::enabled(false);
+FILE* PageTrace::fp = NULL;
+vector<PageTrace::Record> PageTrace::buffer;
+std::chrono::steady_clock::time_point PageTrace::start;
+std::mutex PageTrace::latch;
+
+RC PageTrace::open(const string& path, int pageSize)
+{
+  std::lock_guard<std::mutex> guard(latch);
+  Header header = { MAGIC, VERSION, pageSize, 0 };
+
+  if (fp != NULL) return RC_FILE_OPEN_FAILED;
+  if ((fp = fopen(path.c_str(), "wb")) == NULL) return RC_FILE_OPEN_FAILED;
+
+  if (fwrite(&header, sizeof(header), 1, fp) != 1) {
+    fclose(fp);
+    fp = NULL;
+    return RC_FILE_WRITE_FAILED;
+  }
+
+  buffer.clear();
+  buffer.reserve(BUFFER_RECORDS);
+  start = std::chrono::steady_clock::now();
+  enabled = true;
+  return 0;
+}
+
+RC PageTrace::close()
+{
+  std::lock_guard<std::mutex> guard(latch);
+  RC rc;
+
+  if (fp == NULL) return RC_FILE_CLOSE_FAILED;
+  enabled = false;
+
+  rc = writeOut();
+  if (fclose(fp) != 0 && rc == 0) rc = RC_FILE_CLOSE_FAILED;
+  fp = NULL;
+  return rc;
+}
+
+void PageTrace::record(int fid, PageId pid, int op)
+{
+  if (!enabled) return;
+
+  long long time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  std::lock_guard<std::mutex> guard(latch);
+
+  // the trace may have been closed meanwhile
+  if (fp == NULL) return;
+
+  buffer.push_back(Record::make(time, fid, pid, op));
+  if (buffer.size() >= BUFFER_RECORDS) writeOut();
+}
+
+RC PageTrace::writeOut()
+{
+  size_t n = buffer.size();
+  bool   ok = (n == 0 || fwrite(&buffer[0], sizeof(Record), n, fp) == n);
+
+  buffer.clear();
+  return ok ? 0 : RC_FILE_WRITE_FAILED;
+}
+
+RC PageTrace::load(const string& path, Header& header, vector<Record>& records)
+{
+  FILE*  in;
+  Record block[4096];
+  size_t n;
+
+  records.clear();
+  if ((in = fopen(path.c_str(), "rb")) == NULL) return RC_FILE_OPEN_FAILED;
+
+  if (fread(&header, sizeof(header), 1, in) != 1 || header.magic != MAGIC || header.version != VERSION) {
+    fclose(in);
+    return RC_INVALID_FILE_FORMAT;
+  }
+
+  // a partial record at the end (e.g., of a killed process) is dropped
+  while ((n = fread(block, sizeof(Record), sizeof(block) / sizeof(Record), in)) > 0) {
+    records.insert(records.end(), block, block + n);
+  }
+
+  fclose(in);
+  return 0;
+}
+
+RC PageTrace::save(const string& path, int pageSize, const vector<Record>& records)
+{
+  FILE*  out;
+  Header header = { MAGIC, VERSION, pageSize, 0 };
+
+  if ((out = fopen(path.c_str(), "wb")) == NULL) return RC_FILE_OPEN_FAILED;
+
+  if (fwrite(&header, sizeof(header), 1, out) != 1
+      || (!records.empty() && fwrite(&records[0], sizeof(Record), records.size(), out) != records.size())) {
+    fclose(out);
+    return RC_FILE_WRITE_FAILED;
+  }
+
+  return fclose(out) == 0 ? 0 : RC_FILE_CLOSE_FAILED;
+}
@@ -0,0 +1,120 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/17/2026
+ */
+
+#ifndef PAGETRACE_H
+#define PAGETRACE_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include "Bruinbase.h"
+
+/**
+ * A trace of the page accesses of every PageFile, for sizing the page
+ * cache offline (see cachesim.cc).
+ *
+ * While a trace is open, PageFile::pin() (and so read()) and write() record
+ * the file, page, kind of access and time of every page they are asked for,
+ * whether or not the page cache has it. Records are buffered in memory and
+ * appended to the trace file in large blocks.
+ *
+ * The trace file starts with a Header and is followed by Records, both in
+ * the byte order of the machine that wrote it.
+ */
+class PageTrace {
+ public:
+  static const int READ  = 0;
+  static const int WRITE = 1;
+
+  static const int MAGIC = 0x52544242; // "BBTR"
+  static const int VERSION = 1;
+
+  struct Header {
+    int magic;
+    int version;
+    int pageSize;
+    int reserved;
+  };
+
+  /**
+   * one page access, in 16 bytes
+   */
+  struct Record {
+    long long time; // nanoseconds since the trace was opened
+    long long page; // pid << 16 | fid << 1 | op
+
+    PageId pid() const { return page >> 16; }
+    int    fid() const { return (int)(page >> 1) & 0x7fff; }
+    int    op()  const { return (int)(page & 1); }
+
+    static Record make(long long time, int fid, PageId pid, int op) {
+      Record r = { time, (pid << 16) | ((long long)(fid & 0x7fff) << 1) | (op & 1) };
+      return r;
+    }
+  };
+
+  static const size_t BUFFER_RECORDS = 65536; // records kept in memory
+
+  /**
+   * start recording the page accesses to a new trace file.
+   * @param path[IN] the trace file, replaced if it exists
+   * @param pageSize[IN] the page size to record in the header
+   * @return error code. 0 if no error
+   */
+  static RC open(const std::string& path, int pageSize);
+
+  /**
+   * write out the buffered records and stop recording.
+   * @return error code. 0 if no error
+   */
+  static RC close();
+
+  /**
+   * @return true if page accesses are being recorded
+   */
+  static bool isOpen() { return enabled; }
+
+  /**
+   * record one page access. does nothing unless a trace is open.
+   * @param fid[IN] the page cache id of the file
+   * @param pid[IN] the page
+   * @param op[IN] READ or WRITE
+   */
+  static void record(int fid, PageId pid, int op);
+
+  /**
+   * read a whole trace file.
+   * @param path[IN] the trace file
+   * @param header[OUT] its header
+   * @param records[OUT] its records, in the order they were recorded
+   * @return error code. RC_INVALID_FILE_FORMAT if it is not a trace file
+   */
+  static RC load(const std::string& path, Header& header, std::vector<Record>& records);
+
+  /**
+   * write a whole trace file, e.g., a synthetic one.
+   * @param path[IN] the trace file, replaced if it exists
+   * @param pageSize[IN] the page size to record in the header
+   * @param records[IN] the records to write
+   * @return error code. 0 if no error
+   */
+  static RC save(const std::string& path, int pageSize, const std::vector<Record>& records);
+
+ private:
+  static RC writeOut();
+
+  static std::atomic<bool> enabled;
+  static FILE* fp;                              // the trace file
+  static std::vector<Record> buffer;            // records not written out yet
+  static std::chrono::steady_clock::time_point start; // when the trace was opened
+  static std::mutex latch;                      // protects everything above
+};
+
+#endif // PAGETRACE_H
@@ -9,6 +9,8 @@
 
 #include "Bruinbase.h"
 #include "RecordFile.h"
+#include <algorithm>
+#include <cstring>
 
 using std::string;
 
@@ -16,15 +18,42 @@ using std::string;
 // helper functions for page manipultation
 //
 
-// compute the pointer to the n'th slot in a page
+// the location of a record in a slotted page
+struct Slot {
+  unsigned short offset; // where the record starts in the page
+  unsigned short length; // # of bytes of the record, ORed with OVERFLOW_RECORD
+};
+
+// the slot length flag of a record whose value is in overflow pages. such a
+// record is its key, the length of the value and the first overflow page
+static const unsigned short OVERFLOW_RECORD = 0x8000;
+static const int OVERFLOW_RECORD_LENGTH = 2 * sizeof(int) + sizeof(PageId);
+
+// the record count of an overflow page. an overflow page starts with it,
+// followed by the # of value bytes in the page and the next page of the chain
+static const int OVERFLOW_PAGE = -1;
+static const int OVERFLOW_HEADER = 2 * sizeof(int) + sizeof(PageId);
+static const int OVERFLOW_DATA = PageFile::PAGE_SIZE - OVERFLOW_HEADER;
+static const PageId END_OF_CHAIN = -1; // the next page of the last overflow page
+
+// compute the pointer to the n'th slot in a version 2 page
 static char* slotPtr(char* page, int n);
 
-// read the record in the n'th slot in the page
+// read the record in the n'th slot in a version 2 page
 static void readSlot(const char* page, int n, int& key, std::string& value);
 
-// write the record to the n'th slot in the page
+// write the record to the n'th slot in a version 2 page
 static void writeSlot(char* page, int n, int key, const std::string& value);
 
+// get the n'th slot of the directory of a slotted page
+static Slot getSlot(const char* page, int n);
+
+// set the n'th slot of the directory of a slotted page
+static void setSlot(char* page, int n, const Slot& slot);
+
+// get # free bytes between the directory and the records of a slotted page
+static int getFreeSpace(const char* page);
+
 // get # records stored in the page
 static int getRecordCount(const char* page);
 
@@ -106,6 +135,9 @@ RecordFile::RecordFile()
 {
   erid.pid = 0;
   erid.sid = 0;
+  npid = 0;
+  reserved = 0;
+  fixed = false;
 }
 
 RecordFile::RecordFile(const string& filename, char mode)
@@ -115,18 +147,20 @@ RecordFile::RecordFile(const string& filename, char mode)
 
 RC RecordFile::open(const string& filename, char mode)
 {
-  RC   rc;
-  char page[PageFile::PAGE_SIZE];
+  RC         rc;
+  PinnedPage page;
 
   // open the page file
+  reserved = 0;
   if ((rc = pf.open(filename, mode)) < 0) return rc;
+  fixed = pf.getFormatVersion() < 3;
   
   //
   // in the rest of this function, we set the end record id
   //
 
   // get the end pid of the file
-  erid.pid = pf.endPid();
+  erid.pid = npid = pf.endPid();
 
   // if the end pid is zero, the file is empty.
   // set the end record id to (0, 0).
@@ -138,16 +172,25 @@ RC RecordFile::open(const string& filename, char mode)
   // obtain # records in the last page to set sid of the end record id.
   // read the last page of the file and get # records in the page.
   // remeber that the id of the last page is endPid()-1 not endPid().
-  if ((rc = pf.read(--erid.pid, page)) < 0) {
-    // an error occurred during page read
-    erid.pid = erid.sid = 0;
-    pf.close();
-    return rc;
-  }
-
-  // get # records in the last page
-  erid.sid = getRecordCount(page);
-  if (erid.sid >= RECORDS_PER_PAGE) {
+  // overflow pages may follow the last page with records in a slotted table
+  do {
+    if ((rc = page.pin(pf, --erid.pid)) < 0) {
+      // an error occurred during page read
+      erid.pid = erid.sid = 0;
+      pf.close();
+      return rc;
+    }
+
+    // get # records in the page
+    erid.sid = getRecordCount(page.data());
+  } while (erid.sid == OVERFLOW_PAGE && erid.pid > 0);
+  page.release();
+
+  if (erid.sid == OVERFLOW_PAGE) {
+    // there are only overflow pages. the first record goes to a new page
+    erid.pid = npid;
+    erid.sid = 0;
+  } else if (fixed && erid.sid >= RECORDS_PER_PAGE_V2) {
     // the last page is full. advance the end record id to the next page.
     erid.pid++;
     erid.sid = 0;
@@ -160,59 +203,329 @@ RC RecordFile::close()
 {
   erid.pid = 0;
   erid.sid = 0;
+  npid = 0;
+  reserved = 0;
 
   return pf.close();
 }
 
-RC RecordFile::read(const RecordId& rid, int& key, string& value) const
+RC RecordFile::pinRecord(const RecordId& rid, PinnedPage& page) const
 {
-  RC   rc;
-  char page[PageFile::PAGE_SIZE];
+  RC       rc;
+  RecordId end;
+
+  // records may be appended concurrently
+  appendLatch.lock();
+  end = erid;
+  appendLatch.unlock();
   
   // check whether the rid is in the valid range
-  if (rid.pid < 0 || rid.pid > erid.pid) return RC_INVALID_RID;
-  if (rid.sid < 0 || rid.sid >= RecordFile::RECORDS_PER_PAGE) return RC_INVALID_RID;
-  if (rid >= erid) return RC_INVALID_RID;
+  if (rid.pid < 0 || rid.pid > end.pid) return RC_INVALID_RID;
+  if (rid.sid < 0 || (fixed && rid.sid >= RECORDS_PER_PAGE_V2)) return RC_INVALID_RID;
+  if (rid >= end) return RC_INVALID_RID;
   
-  // read the page containing the record
-  if ((rc = pf.read(rid.pid, page)) < 0) return rc;
+  // pin the page containing the record; the slot is read in place
+  if ((rc = page.pin(pf, rid.pid)) < 0) return rc;
+
+  if (!fixed && rid.sid >= getRecordCount(page.data())) return RC_INVALID_RID;
+  return 0;
+}
+
+RC RecordFile::read(const RecordId& rid, int& key, string& value) const
+{
+  RC         rc;
+  PinnedPage page;
+  Slot       slot;
+
+  if ((rc = pinRecord(rid, page)) < 0) return rc;
 
   // read the record from the slot in the page
-  readSlot(page, rid.sid, key, value);
+  if (fixed) {
+    readSlot(page.data(), rid.sid, key, value);
+    return 0;
+  }
+
+  slot = getSlot(page.data(), rid.sid);
+  memcpy(&key, page.data() + slot.offset, sizeof(int));
+  if (!(slot.length & OVERFLOW_RECORD)) {
+    value.assign(page.data() + slot.offset + sizeof(int), slot.length - sizeof(int));
+    return 0;
+  }
+
+  // the value is in a chain of overflow pages
+  int    length;
+  PageId first;
+  memcpy(&length, page.data() + slot.offset + sizeof(int), sizeof(int));
+  memcpy(&first, page.data() + slot.offset + 2 * sizeof(int), sizeof(PageId));
+  page.release();
+
+  return readOverflow(first, length, value);
+}
+
+RC RecordFile::readKey(const RecordId& rid, int& key) const
+{
+  RC         rc;
+  PinnedPage page;
 
+  if ((rc = pinRecord(rid, page)) < 0) return rc;
+
+  // the key comes first in both layouts
+  if (fixed) {
+    memcpy(&key, slotPtr(const_cast<char*>(page.data()), rid.sid), sizeof(int));
+  } else {
+    memcpy(&key, page.data() + getSlot(page.data(), rid.sid).offset, sizeof(int));
+  }
+  return 0;
+}
+
+RC RecordFile::readValue(const RecordId& rid, string& value) const
+{
+  int key;
+
+  // the value is stored next to the key; nothing is saved by skipping it
+  return read(rid, key, value);
+}
+
+RC RecordFile::readValue(const RecordId& rid, ValueRef& ref) const
+{
+  RC   rc;
+  Slot slot;
+
+  ref.clear();
+  if ((rc = pinRecord(rid, ref.page)) < 0) return rc;
+
+  if (fixed) {
+    ref.value.data = slotPtr(const_cast<char*>(ref.page.data()), rid.sid) + sizeof(int);
+    ref.value.length = (int)strnlen(ref.value.data, MAX_VALUE_LENGTH);
+    return 0;
+  }
+
+  slot = getSlot(ref.page.data(), rid.sid);
+  if (!(slot.length & OVERFLOW_RECORD)) {
+    ref.value.data = ref.page.data() + slot.offset + sizeof(int);
+    ref.value.length = slot.length - sizeof(int);
+    return 0;
+  }
+
+  // the value is in a chain of overflow pages
+  int    length;
+  PageId first;
+  memcpy(&length, ref.page.data() + slot.offset + sizeof(int), sizeof(int));
+  memcpy(&first, ref.page.data() + slot.offset + 2 * sizeof(int), sizeof(PageId));
+  ref.page.release();
+
+  if ((rc = readOverflow(first, length, ref.copy)) < 0) return rc;
+  ref.value.data = ref.copy.data();
+  ref.value.length = (int)ref.copy.size();
   return 0;
 }
 
 RC RecordFile::append(int key, const std::string& value, RecordId& rid)
+{
+  std::lock_guard<std::mutex> guard(appendLatch);
+
+  return appendRecords(&key, &value, 1, &rid);
+}
+
+RC RecordFile::appendBatch(const std::vector<int>& keys, const std::vector<std::string>& values, std::vector<RecordId>& rids)
+{
+  std::lock_guard<std::mutex> guard(appendLatch);
+
+  if (keys.size() != values.size()) return RC_INVALID_ATTRIBUTE;
+  rids.resize(keys.size());
+  if (keys.empty()) return 0;
+
+  return appendRecords(&keys[0], &values[0], (int)keys.size(), &rids[0]);
+}
+
+RC RecordFile::appendRecords(const int* keys, const std::string* values, int n, RecordId* rids)
 {
   RC   rc;
   char page[PageFile::PAGE_SIZE];
+  bool dirty = false; // whether the page holds records not written yet
+
+  // the records go to the last page first
+  if ((rc = startPage(page)) < 0) return rc;
+
+  for (int i = 0; i < n; i++) {
+    // a full page is written once, and the records continue in a new one
+    if (!fits(page, values[i])) {
+      if (dirty && (rc = pf.write(erid.pid, page)) < 0) return rc;
+      dirty = false;
+      if ((rc = nextPage(page)) < 0) return rc;
+    }
+
+    // we need to output the rid of the record slot
+    if ((rc = placeRecord(page, keys[i], values[i])) < 0) return rc;
+    rids[i] = erid;
+    dirty = true;
+
+    // advance the end record id by one to the next empty slot
+    erid.sid++;
+  }
+
+  // write the page to the disk
+  if (dirty && (rc = pf.write(erid.pid, page)) < 0) return rc;
+
+  // a full page of a version 2 table is followed by the next one
+  if (fixed && erid.sid >= RECORDS_PER_PAGE_V2) {
+    erid.pid++;
+    erid.sid = 0;
+  }
+
+  return 0;
+}
+
+RC RecordFile::startPage(char* page)
+{
+  RC rc;
 
   // unless we are writing to the the first slot of an empty page,
   // we have to read the page first
-  if (erid.sid > 0) {
-    if ((rc = pf.read(erid.pid, page)) < 0) return rc;
+  if (fixed ? erid.sid > 0 : erid.pid < npid) return pf.read(erid.pid, page);
+
+  // if this is the first slot of an empty page
+  // we can simply initialize the page with zeros
+  if (fixed) {
+    if ((rc = reservePage(erid.pid)) < 0) return rc;
   } else {
-    // if this is the first slot of an empty page
-    // we can simply initialize the page with zeros
-    memset(page, 0, PageFile::PAGE_SIZE);
+    if ((rc = newPage(erid.pid)) < 0) return rc;
+  }
+  erid.sid = 0;
+  memset(page, 0, PageFile::PAGE_SIZE);
+
+  return 0;
+}
+
+RC RecordFile::nextPage(char* page)
+{
+  RC rc;
+
+  // the pages of a version 2 table follow each other. a slotted table
+  // may have overflow pages in between
+  if (fixed) {
+    if ((rc = reservePage(++erid.pid)) < 0) return rc;
+  } else {
+    if ((rc = newPage(erid.pid)) < 0) return rc;
   }
-    
+  erid.sid = 0;
+  memset(page, 0, PageFile::PAGE_SIZE);
+
+  return 0;
+}
+
+bool RecordFile::fits(const char* page, const std::string& value) const
+{
+  if (fixed) return erid.sid < RECORDS_PER_PAGE_V2;
+
+  // a long value goes to overflow pages; the record only points to them
+  int length = ((int)value.size() > MAX_INLINE_VALUE) ? OVERFLOW_RECORD_LENGTH : (int)(sizeof(int) + value.size());
+  return getFreeSpace(page) >= length + (int)sizeof(Slot);
+}
+
+RC RecordFile::placeRecord(char* page, int key, const std::string& value)
+{
+  RC     rc;
+  Slot   slot;
+  PageId first;
+
   // write the record to the first empty slot 
-  writeSlot(page, erid.sid, key, value);
+  if (fixed) {
+    writeSlot(page, erid.sid, key, value);
+
+    // the first four bytes in the page stores # records in the page.
+    // update this number.
+    setRecordCount(page, erid.sid + 1);
+    return 0;
+  }
+
+  bool overflow = (int)value.size() > MAX_INLINE_VALUE;
+  int  length = overflow ? OVERFLOW_RECORD_LENGTH : (int)(sizeof(int) + value.size());
 
-  // the first four bytes in the page stores # records in the page.
-  // update this number.
+  if (overflow && (rc = writeOverflow(value, first)) < 0) return rc;
+
+  // the records fill the page from its end; each goes in front of the last one
+  slot.offset = (unsigned short)((erid.sid > 0 ? getSlot(page, erid.sid - 1).offset : PageFile::PAGE_SIZE) - length);
+  slot.length = (unsigned short)(length | (overflow ? OVERFLOW_RECORD : 0));
+  memcpy(page + slot.offset, &key, sizeof(int));
+  if (overflow) {
+    int n = (int)value.size();
+    memcpy(page + slot.offset + sizeof(int), &n, sizeof(int));
+    memcpy(page + slot.offset + 2 * sizeof(int), &first, sizeof(PageId));
+  } else {
+    memcpy(page + slot.offset + sizeof(int), value.data(), value.size());
+  }
+  setSlot(page, erid.sid, slot);
   setRecordCount(page, erid.sid + 1);
 
-  // write the page to the disk
-  if ((rc = pf.write(erid.pid, page)) < 0) return rc;
-    
-  // we need to output the rid of the record slot
-  rid = erid;
+  return 0;
+}
+
+RC RecordFile::newPage(PageId& pid)
+{
+  pid = npid++;
+  return reservePage(pid);
+}
+
+RC RecordFile::reservePage(PageId pid)
+{
+  RC rc;
+
+  // reserve disk space for a whole extent of pages at a time,
+  // so that the file does not grow one page at a time
+  if (pid >= reserved) {
+    if ((rc = pf.reserve(pid, PageFile::EXTENT_PAGES)) < 0) return rc;
+    reserved = pid + PageFile::EXTENT_PAGES;
+  }
+
+  return 0;
+}
+
+RC RecordFile::writeOverflow(const std::string& value, PageId& first)
+{
+  RC     rc;
+  char   page[PageFile::PAGE_SIZE];
+  int    count = OVERFLOW_PAGE;
+  PageId pid, next;
+
+  // the pages of the chain are allocated one after the other
+  if ((rc = newPage(pid)) < 0) return rc;
+  first = pid;
+
+  for (size_t done = 0; done < value.size(); done += OVERFLOW_DATA, pid = next) {
+    int n = (int)std::min(value.size() - done, (size_t)OVERFLOW_DATA);
+
+    next = END_OF_CHAIN;
+    if (done + n < value.size() && (rc = newPage(next)) < 0) return rc;
+
+    memset(page, 0, PageFile::PAGE_SIZE);
+    memcpy(page, &count, sizeof(int));
+    memcpy(page + sizeof(int), &n, sizeof(int));
+    memcpy(page + 2 * sizeof(int), &next, sizeof(PageId));
+    memcpy(page + OVERFLOW_HEADER, value.data() + done, n);
+    if ((rc = pf.write(pid, page)) < 0) return rc;
+  }
+
+  return 0;
+}
 
-  // advance the end record id by one to the next empty slot
-  ++erid;
+RC RecordFile::readOverflow(PageId pid, int length, string& value) const
+{
+  RC         rc;
+  PinnedPage page;
+  int        n;
+
+  value.clear();
+  value.reserve(length);
+  while ((int)value.size() < length) {
+    if ((rc = page.pin(pf, pid)) < 0) return rc;
+    if (getRecordCount(page.data()) != OVERFLOW_PAGE) return RC_INVALID_FILE_FORMAT;
+
+    memcpy(&n, page.data() + sizeof(int), sizeof(int));
+    memcpy(&pid, page.data() + 2 * sizeof(int), sizeof(PageId));
+    if (n <= 0 || n > OVERFLOW_DATA || (int)value.size() + n > length) return RC_INVALID_FILE_FORMAT;
+    value.append(page.data() + OVERFLOW_HEADER, n);
+  }
 
   return 0;
 }
@@ -222,6 +535,156 @@ const RecordId& RecordFile::endRid() const
   return erid;
 }
 
+RC RecordFile::seek(RecordId& rid) const
+{
+  RC         rc;
+  PinnedPage page;
+  RecordId   end;
+
+  // records may be appended concurrently
+  appendLatch.lock();
+  end = erid;
+  appendLatch.unlock();
+
+  // skip the rest of the page once its records run out.
+  // overflow pages have no records and are skipped as a whole
+  while (rid < end) {
+    if (fixed) {
+      if (rid.sid < RECORDS_PER_PAGE_V2) return 0;
+    } else {
+      if ((rc = page.pin(pf, rid.pid)) < 0) return rc;
+      if (rid.sid < getRecordCount(page.data())) return 0;
+    }
+    rid.pid++;
+    rid.sid = 0;
+  }
+
+  return RC_NO_SUCH_RECORD;
+}
+
+RC RecordFile::next(RecordId& rid) const
+{
+  rid.sid++;
+  return seek(rid);
+}
+
+RC RecordFile::nextBatch(RecordId& rid, ScanBatch& batch) const
+{
+  RC       rc;
+  RecordId end;
+  int      key;
+
+  batch.clear();
+  if ((rc = seek(rid)) < 0) return rc;
+
+  appendLatch.lock();
+  end = erid;
+  appendLatch.unlock();
+
+  // the page stays pinned for readValues()
+  if ((rc = batch.page.pin(pf, rid.pid)) < 0) return rc;
+  batch.pid = rid.pid;
+  batch.first = rid.sid;
+
+  if (fixed) {
+    batch.count = ((rid.pid == end.pid) ? end.sid : RECORDS_PER_PAGE_V2) - rid.sid;
+  } else {
+    batch.count = getRecordCount(batch.page.data()) - rid.sid;
+  }
+
+  batch.keys.resize(batch.count);
+  for (int i = 0; i < batch.count; i++) {
+    if (fixed) {
+      memcpy(&key, slotPtr(const_cast<char*>(batch.page.data()), rid.sid + i), sizeof(int));
+    } else {
+      memcpy(&key, batch.page.data() + getSlot(batch.page.data(), rid.sid + i).offset, sizeof(int));
+    }
+    batch.keys[i] = key;
+  }
+
+  rid.pid++;
+  rid.sid = 0;
+  return 0;
+}
+
+RC RecordFile::readValues(ScanBatch& batch) const
+{
+  RC          rc;
+  Slot        slot;
+  const char* page = batch.page.data();
+
+  // the chains of overflow pages are read into the page cache too. the
+  // page is copied and released first, so that its pin does not keep a
+  // frame of a small cache from them
+  for (int i = 0; !fixed && i < batch.count; i++) {
+    if (getSlot(page, batch.first + i).length & OVERFLOW_RECORD) {
+      batch.copy.assign(page, PageFile::PAGE_SIZE);
+      batch.page.release();
+      page = batch.copy.data();
+      batch.overflow.resize(batch.count);
+      break;
+    }
+  }
+
+  batch.values.resize(batch.count);
+  for (int i = 0; i < batch.count; i++) {
+    ValueView& view = batch.values[i];
+
+    if (fixed) {
+      view.data = slotPtr(const_cast<char*>(page), batch.first + i) + sizeof(int);
+      view.length = (int)strnlen(view.data, MAX_VALUE_LENGTH);
+      continue;
+    }
+
+    slot = getSlot(page, batch.first + i);
+    if (!(slot.length & OVERFLOW_RECORD)) {
+      view.data = page + slot.offset + sizeof(int);
+      view.length = slot.length - sizeof(int);
+      continue;
+    }
+
+    // the value is in a chain of overflow pages
+    int    length;
+    PageId first;
+    memcpy(&length, page + slot.offset + sizeof(int), sizeof(int));
+    memcpy(&first, page + slot.offset + 2 * sizeof(int), sizeof(PageId));
+
+    if ((rc = readOverflow(first, length, batch.overflow[i])) < 0) return rc;
+    view.data = batch.overflow[i].data();
+    view.length = (int)batch.overflow[i].size();
+  }
+
+  return 0;
+}
+
+RC RecordFile::prefetch(const std::vector<RecordId>& rids) const
+{
+  std::vector<PageId> pids;
+
+  // records of the same page are usually next to each other
+  for (unsigned i = 0; i < rids.size(); i++) {
+    if (pids.empty() || pids.back() != rids[i].pid) pids.push_back(rids[i].pid);
+  }
+
+  return pf.prefetch(pids);
+}
+
+RC RecordFile::prewarm(int maxPages, int& count) const
+{
+  std::vector<PageId> pids;
+  PageId end = pf.endPid();
+
+  for (PageId pid = 0; pid < end && (int)pids.size() < maxPages; pid++) pids.push_back(pid);
+  count = (int)pids.size();
+
+  return pf.prewarm(pids);
+}
+
+RC RecordFile::setAccessPattern(PageFile::AccessPattern pattern)
+{
+  return pf.setAccessPattern(pattern);
+}
+
 static int getRecordCount(const char* page)
 {
   int count;
@@ -237,6 +700,29 @@ static void setRecordCount(char* page, int count)
   memcpy(page, &count, sizeof(int));
 }
 
+static Slot getSlot(const char* page, int n)
+{
+  Slot slot;
+
+  // the directory follows the record count
+  memcpy(&slot, page + sizeof(int) + n * sizeof(Slot), sizeof(Slot));
+  return slot;
+}
+
+static void setSlot(char* page, int n, const Slot& slot)
+{
+  memcpy(page + sizeof(int) + n * sizeof(Slot), &slot, sizeof(Slot));
+}
+
+static int getFreeSpace(const char* page)
+{
+  int count = getRecordCount(page);
+  int start = (count > 0) ? getSlot(page, count - 1).offset : PageFile::PAGE_SIZE;
+
+  // the records start right after the free space
+  return start - (int)(sizeof(int) + count * sizeof(Slot));
+}
+
 static char* slotPtr(char* page, int n) 
 {
   // compute the location of the n'th slot in a page.
@@ -11,47 +11,47 @@
 #define RECORDFILE_H
 
 #include <string>
+#include <vector>
+#include <mutex>
 #include "PageFile.h"
+#include "TableFile.h"
 
 /**
- * The data structure for pointing to a particular record in a RecordFile.
- * A record id consists of pid (PageId) and sid (the slot number in the page)
- */
-typedef struct {
-  PageId  pid;  // page number. the first page is 0
-  int     sid;  // slot number. the first slot is 0
-} RecordId;
-
-//
-// helper functions for RecordId
-// 
-
-// RecordId iterators
-RecordId& operator++ (RecordId& rid);
-RecordId  operator++ (RecordId& rid, int);
-
-// RecordId comparators
-bool operator> (const RecordId& r1, const RecordId& r2);
-bool operator< (const RecordId& r1, const RecordId& r2);
-bool operator>= (const RecordId& r1, const RecordId& r2);
-bool operator<= (const RecordId& r1, const RecordId& r2);
-bool operator== (const RecordId& r1, const RecordId& r2);
-bool operator!= (const RecordId& r1, const RecordId& r2);
-
-/**
- * read/write a record to a file
+ * read/write a record to a file, storing the table by rows.
+ * records may be read and appended from several threads at once;
+ * appends are serialized.
+ *
+ * records are stored in slotted pages. a page starts with the # of records
+ * in it, followed by a directory of one slot per record (the offset and
+ * length of the record in the page). the records themselves fill the page
+ * from its end towards the directory, so that a page holds as many records
+ * as their lengths allow. a record is its key followed by its value.
+ * a value longer than MAX_INLINE_VALUE is stored in a chain of overflow
+ * pages, and the record only holds its length and the first page of the
+ * chain. overflow pages hold no records.
+ *
+ * tables written in version 2 of the file format (see PageFile) use the
+ * earlier layout: RECORDS_PER_PAGE_V2 fixed-size slots per page, each
+ * holding a key and a value truncated to MAX_VALUE_LENGTH - 1 characters.
+ * such tables can still be read and appended to.
  */
-class RecordFile {
+class RecordFile : public TableFile {
  public:
 
-  // maximum length of the value field
+  // maximum length of the value field of a version 2 table
   static const int MAX_VALUE_LENGTH = 100;  
 
-  // number of record slots per page
-  static const int RECORDS_PER_PAGE = (PageFile::PAGE_SIZE - sizeof(int))/ (sizeof(int) + MAX_VALUE_LENGTH);  
+  // number of record slots per page of a version 2 table
+  static const int RECORDS_PER_PAGE_V2 = (PageFile::PAGE_SIZE - sizeof(int))/ (sizeof(int) + MAX_VALUE_LENGTH);  
     // Note that we subtract sizeof(int) from PAGE_SIZE because the first
     // four bytes in the page is used to store # records in the page.
 
+  // maximum number of records per page: records with an empty value
+  static const int RECORDS_PER_PAGE = (PageFile::PAGE_SIZE - sizeof(int)) / (2 * sizeof(int));
+
+  // longest value stored in the page of its record
+  static const int MAX_INLINE_VALUE = PageFile::PAGE_SIZE / 4 - sizeof(int);
+
   RecordFile();
   RecordFile(const std::string& filename, char mode);
   
@@ -79,6 +79,31 @@ class RecordFile {
    */
   RC read(const RecordId& rid, int& key, std::string& value) const;
 
+  /**
+   * read only the key of a record.
+   * @param rid[IN] the id of the record to read
+   * @param key[OUT] the record key
+   * @return error code. 0 if no error
+   */
+  RC readKey(const RecordId& rid, int& key) const;
+
+  /**
+   * read only the value of a record.
+   * @param rid[IN] the id of the record to read
+   * @param value[OUT] the record value
+   * @return error code. 0 if no error
+   */
+  RC readValue(const RecordId& rid, std::string& value) const;
+
+  /**
+   * read only the value of a record, in place in its page. a value stored
+   * in overflow pages is copied into ref.
+   * @param rid[IN] the id of the record to read
+   * @param ref[OUT] the record value, valid until ref is cleared or reused
+   * @return error code. 0 if no error
+   */
+  RC readValue(const RecordId& rid, ValueRef& ref) const;
+
   /**
    * append a new record at the end of the file.
    * note that RecordFile does not have write() function.
@@ -90,15 +115,100 @@ class RecordFile {
    */
   RC append(int key, const std::string& value, RecordId& rid);
 
+  /**
+   * append a batch of records at the end of the file. the pages are
+   * filled in memory and each page is written once, so that appending
+   * many records costs about one page write per page of records, rather
+   * than a page read and write per record as with append().
+   * @param keys[IN] the record keys
+   * @param values[IN] the record values, one for each key
+   * @param rids[OUT] the location of each stored record
+   * @return error code. 0 if no error
+   */
+  RC appendBatch(const std::vector<int>& keys, const std::vector<std::string>& values, std::vector<RecordId>& rids);
+
   /**
    * note the +1 part. The rid of the last record is endRid()-1.
    * @return (last record id + 1) of the RecordFile
    */
   const RecordId& endRid() const;
 
+  /**
+   * move a record id forward to the first record at or after it. as the
+   * # of records differs from page to page, a scan of the file moves from
+   * one record to the next with this function (or next()) rather than ++.
+   * @param rid[IN/OUT] the record id to move, e.g., (0, 0) to find the first record
+   * @return error code. RC_NO_SUCH_RECORD if no record is left
+   */
+  RC seek(RecordId& rid) const;
+
+  /**
+   * move a record id to the next record of the file.
+   * @param rid[IN/OUT] the id of a record
+   * @return error code. RC_NO_SUCH_RECORD if it was the last record
+   */
+  RC next(RecordId& rid) const;
+
+  /**
+   * read the keys of the records of a page in one go, starting at the
+   * first record at or after a record id. the page is fetched once for
+   * all of its records, rather than once per record as with read().
+   * @param rid[IN/OUT] where the scan is; moved to the first record of the next page
+   * @param batch[OUT] the records read
+   * @return error code. RC_NO_SUCH_RECORD if no record is left
+   */
+  RC nextBatch(RecordId& rid, ScanBatch& batch) const;
+
+  /**
+   * read the values of the records of a batch read by nextBatch(). values
+   * stored in the page are read in place; only values in overflow pages
+   * are copied.
+   * @param batch[IN/OUT] the batch
+   * @return error code. 0 if no error
+   */
+  RC readValues(ScanBatch& batch) const;
+
+  /**
+   * read the pages holding a set of records into the page cache, with
+   * the reads in flight together. later read()s of the records hit the cache.
+   * @param rids[IN] the records that are going to be read
+   * @return error code. 0 if no error
+   */
+  RC prefetch(const std::vector<RecordId>& rids) const;
+
+  /**
+   * read the first pages of the file into the page cache, in order.
+   * @param maxPages[IN] the most pages to read
+   * @param count[OUT] the # of pages read
+   * @return error code. 0 if no error
+   */
+  RC prewarm(int maxPages, int& count) const;
+
+  /**
+   * tell the kernel in which order the records are going to be read.
+   * @param pattern[IN] the expected access pattern
+   * @return error code. 0 if no error
+   */
+  RC setAccessPattern(PageFile::AccessPattern pattern);
+
  private:
+  RC pinRecord(const RecordId& rid, PinnedPage& page) const;
+  RC appendRecords(const int* keys, const std::string* values, int n, RecordId* rids);
+  RC startPage(char* page);
+  RC nextPage(char* page);
+  bool fits(const char* page, const std::string& value) const;
+  RC placeRecord(char* page, int key, const std::string& value);
+  RC newPage(PageId& pid);
+  RC reservePage(PageId pid);
+  RC writeOverflow(const std::string& value, PageId& first);
+  RC readOverflow(PageId pid, int length, std::string& value) const;
+
   PageFile pf;     // the PageFile used to store the records
   RecordId erid;   // the last record id of the file + 1
+  PageId   npid;   // the first page not in use yet (slotted tables)
+  PageId   reserved; // the end of the disk space reserved for appends
+  bool     fixed;  // whether the table uses the fixed-size slots of version 2
+  mutable std::mutex appendLatch; // protects erid, npid, reserved and the last page
 };
 
 #endif // RECORDFILE_H
@@ -0,0 +1,391 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/17/2026
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <climits>
+#include <fstream>
+#include <sstream>
+#include "Schema.h"
+#include "PageFile.h"
+
+using namespace std;
+
+// the # of bytes of the slot of each type; that of a CHAR is its length
+static const int SLOT_LENGTH[] = { 4, 8, 8, 0, 4 };
+
+static const char* TYPE_NAME[] = { "int", "bigint", "double", "char", "varchar" };
+
+// parse a whole string as an integer
+static bool parseInteger(const char* s, long long& value)
+{
+  char* end;
+
+  errno = 0;
+  value = strtoll(s, &end, 10);
+  return end != s && *end == 0 && errno == 0;
+}
+
+// parse a whole string as a real
+static bool parseReal(const char* s, double& value)
+{
+  char* end;
+
+  errno = 0;
+  value = strtod(s, &end);
+  return end != s && *end == 0 && errno == 0;
+}
+
+// compare two strings the way strcmp() does
+static int compareText(const char* a, int alength, const char* b, int blength)
+{
+  int diff = memcmp(a, b, (alength < blength) ? alength : blength);
+
+  return (diff != 0) ? diff : alength - blength;
+}
+
+/*
+ * read the field of a load file line starting at s, and move s to the
+ * comma after it or the end of the line. a field quoted by ' or " ends at
+ * the next quote; an unquoted one has its surrounding white spaces removed.
+ */
+static void readField(const char*& s, string& field, bool& quoted)
+{
+  const char* begin;
+  const char* end;
+
+  while (*s == ' ' || *s == '\t') s++;
+
+  quoted = (*s == '\'' || *s == '"');
+  if (quoted) {
+    begin = s + 1;
+    end = strchr(begin, *s);
+    if (end == NULL) end = begin + strlen(begin);
+    field.assign(begin, end - begin);
+    s = end;
+  } else {
+    begin = s;
+    end = s + strcspn(s, ",");
+    while (end > begin && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) end--;
+    field.assign(begin, end - begin);
+  }
+  s += strcspn(s, ",");
+}
+
+Schema::Schema()
+{
+  Column key   = { "key", INT, 0, -1 };
+  Column value = { "value", VARCHAR, 0, -1 };
+
+  columns.push_back(key);
+  columns.push_back(value);
+  typed = false;
+  fixedLength = 0;
+}
+
+void Schema::layout()
+{
+  // the NULL bitmap, then the slots
+  fixedLength = ((int)columns.size() - 1 + 7) / 8;
+  for (unsigned i = 1; i < columns.size(); i++) {
+    columns[i].slot = fixedLength;
+    fixedLength += (columns[i].type == CHAR) ? columns[i].length : SLOT_LENGTH[columns[i].type];
+  }
+}
+
+RC Schema::addColumn(const string& name, const string& type, int length)
+{
+  Column column;
+
+  // the columns of a new table replace those of a table without a schema
+  if (!typed) {
+    columns.clear();
+    typed = true;
+  }
+
+  if (find(name) >= 0) return RC_INVALID_SCHEMA;
+
+  column.name = name;
+  column.length = length;
+  column.slot = -1;
+  if (type == "int" || type == "integer") {
+    column.type = INT;
+  } else if (type == "bigint") {
+    column.type = BIGINT;
+  } else if (type == "double") {
+    column.type = DOUBLE;
+  } else if (type == "char") {
+    column.type = CHAR;
+    if (length == 0) column.length = 1;
+  } else if (type == "varchar") {
+    column.type = VARCHAR;
+  } else {
+    return RC_INVALID_SCHEMA;
+  }
+
+  // only strings have a length, and the key is an INT
+  if (column.type == CHAR && (column.length < 1 || column.length > MAX_CHAR_LENGTH)) return RC_INVALID_SCHEMA;
+  if (column.type == VARCHAR && (column.length < 1 || column.length > MAX_ROW_LENGTH)) return RC_INVALID_SCHEMA;
+  if (column.type != CHAR && column.type != VARCHAR && length != 0) return RC_INVALID_SCHEMA;
+  if (columns.empty() && column.type != INT) return RC_INVALID_SCHEMA;
+
+  columns.push_back(column);
+  layout();
+  if (fixedLength > MAX_ROW_LENGTH) {
+    columns.pop_back();
+    layout();
+    return RC_INVALID_SCHEMA;
+  }
+
+  return 0;
+}
+
+RC Schema::read(const string& table)
+{
+  ifstream ifs((table + ".schema").c_str());
+  string   name, type;
+  int      length;
+
+  *this = Schema();
+  if (!ifs.good()) return 0;
+
+  while (ifs >> name >> type >> length) {
+    if (addColumn(name, type, length) < 0) return RC_INVALID_FILE_FORMAT;
+  }
+  if (!ifs.eof() || !typed) return RC_INVALID_FILE_FORMAT;
+
+  return 0;
+}
+
+RC Schema::write(const string& table) const
+{
+  ostringstream oss;
+
+  for (unsigned i = 0; i < columns.size(); i++) {
+    oss << columns[i].name << ' ' << TYPE_NAME[columns[i].type] << ' ' << columns[i].length << '\n';
+  }
+
+  // a table without its schema reads as one of two columns, so the schema
+  // file has to be complete and on disk before the table is created
+  const string text = oss.str();
+  return PageFile::replaceFile(table + ".schema", text.data(), text.size(), true);
+}
+
+bool Schema::exists(const string& table)
+{
+  return ifstream((table + ".schema").c_str()).good();
+}
+
+int Schema::find(const string& name) const
+{
+  for (unsigned i = 0; i < columns.size(); i++) {
+    if (columns[i].name == name) return (int)i;
+  }
+  return -1;
+}
+
+RC Schema::bind(int column, const char* value, Operand& operand) const
+{
+  const Column& c = columns[column];
+
+  operand.type = c.type;
+  operand.slot = c.slot;
+  operand.bit = column - 1;
+  operand.width = c.length;
+  operand.integer = 0;
+  operand.real = 0;
+  operand.text = value;
+  operand.length = (int)strlen(value);
+
+  // the key is compared as it always was
+  if (column == 0) {
+    operand.integer = atoi(value);
+    return 0;
+  }
+
+  switch (c.type) {
+  case INT:
+  case BIGINT:
+    if (!parseInteger(value, operand.integer)) return RC_INVALID_ATTRIBUTE;
+    break;
+  case DOUBLE:
+    if (!parseReal(value, operand.real)) return RC_INVALID_ATTRIBUTE;
+    break;
+  case CHAR:
+  case VARCHAR:
+    break;
+  }
+
+  return 0;
+}
+
+bool Schema::compare(const Operand& operand, const ValueView& row, int& diff)
+{
+  const char*    slot = row.data + operand.slot;
+  int            i;
+  long long      ll;
+  double         d;
+  unsigned short offset, length;
+
+  if (row.data[operand.bit / 8] & (1 << (operand.bit % 8))) return false;
+
+  // the column is read where it is, in its binary form
+  switch (operand.type) {
+  case INT:
+    memcpy(&i, slot, sizeof(i));
+    diff = (i > operand.integer) - (i < operand.integer);
+    break;
+  case BIGINT:
+    memcpy(&ll, slot, sizeof(ll));
+    diff = (ll > operand.integer) - (ll < operand.integer);
+    break;
+  case DOUBLE:
+    memcpy(&d, slot, sizeof(d));
+    diff = (d > operand.real) - (d < operand.real);
+    break;
+  case CHAR:
+    diff = compareText(slot, (int)strnlen(slot, operand.width), operand.text, operand.length);
+    break;
+  case VARCHAR:
+    memcpy(&offset, slot, sizeof(offset));
+    memcpy(&length, slot + sizeof(offset), sizeof(length));
+    diff = compareText(row.data + offset, length, operand.text, operand.length);
+    break;
+  }
+
+  return true;
+}
+
+RC Schema::parseRow(const string& line, int& key, string& row) const
+{
+  const char*    s = line.c_str();
+  string         field;
+  bool           quoted;
+  long long      ll;
+  double         d;
+  int            i;
+  unsigned short offset, length;
+
+  // the key
+  readField(s, field, quoted);
+  if (!parseInteger(field.c_str(), ll) || ll < INT_MIN || ll > INT_MAX) return RC_INVALID_FILE_FORMAT;
+  key = (int)ll;
+
+  row.assign(fixedLength, '\0');
+  for (unsigned c = 1; c < columns.size(); c++) {
+    const Column& column = columns[c];
+    char*         slot;
+
+    if (*s++ != ',') return RC_INVALID_FILE_FORMAT;
+    readField(s, field, quoted);
+
+    if (!quoted && field == "\\N") {
+      row[(c - 1) / 8] |= (char)(1 << ((c - 1) % 8));
+      continue;
+    }
+
+    // the row may have grown since the last slot was written
+    slot = &row[column.slot];
+    switch (column.type) {
+    case INT:
+      if (!parseInteger(field.c_str(), ll) || ll < INT_MIN || ll > INT_MAX) return RC_INVALID_FILE_FORMAT;
+      i = (int)ll;
+      memcpy(slot, &i, sizeof(i));
+      break;
+    case BIGINT:
+      if (!parseInteger(field.c_str(), ll)) return RC_INVALID_FILE_FORMAT;
+      memcpy(slot, &ll, sizeof(ll));
+      break;
+    case DOUBLE:
+      if (!parseReal(field.c_str(), d)) return RC_INVALID_FILE_FORMAT;
+      memcpy(slot, &d, sizeof(d));
+      break;
+    case CHAR:
+      if ((int)field.size() > column.length) return RC_INVALID_FILE_FORMAT;
+      memcpy(slot, field.data(), field.size());
+      break;
+    case VARCHAR:
+      if ((int)field.size() > column.length || row.size() + field.size() > (size_t)MAX_ROW_LENGTH) return RC_INVALID_FILE_FORMAT;
+      offset = (unsigned short)row.size();
+      length = (unsigned short)field.size();
+      memcpy(slot, &offset, sizeof(offset));
+      memcpy(slot + sizeof(offset), &length, sizeof(length));
+      row.append(field);
+      break;
+    }
+  }
+
+  // every field is a column
+  return (*s == 0) ? 0 : RC_INVALID_FILE_FORMAT;
+}
+
+void Schema::printField(FILE* fp, int c, const ValueView& row, bool quote) const
+{
+  const Column&  column = columns[c];
+  const char*    slot = row.data + column.slot;
+  const int      bit = c - 1;
+  int            i;
+  long long      ll;
+  double         d;
+  unsigned short offset, length;
+
+  if (row.data[bit / 8] & (1 << (bit % 8))) {
+    fprintf(fp, "NULL");
+    return;
+  }
+
+  switch (column.type) {
+  case INT:
+    memcpy(&i, slot, sizeof(i));
+    fprintf(fp, "%d", i);
+    break;
+  case BIGINT:
+    memcpy(&ll, slot, sizeof(ll));
+    fprintf(fp, "%lld", ll);
+    break;
+  case DOUBLE:
+    memcpy(&d, slot, sizeof(d));
+    fprintf(fp, "%.15g", d);
+    break;
+  case CHAR:
+    fprintf(fp, quote ? "'%.*s'" : "%.*s", (int)strnlen(slot, column.length), slot);
+    break;
+  case VARCHAR:
+    memcpy(&offset, slot, sizeof(offset));
+    memcpy(&length, slot + sizeof(offset), sizeof(length));
+    fprintf(fp, quote ? "'%.*s'" : "%.*s", (int)length, row.data + offset);
+    break;
+  }
+}
+
+void Schema::printColumn(FILE* fp, int column, int key, const ValueView& row) const
+{
+  if (column == 0) {
+    fprintf(fp, "%d\n", key);
+  } else if (!typed) {
+    fprintf(fp, "%.*s\n", row.length, row.data);
+  } else {
+    printField(fp, column, row, false);
+    fputc('\n', fp);
+  }
+}
+
+void Schema::printRow(FILE* fp, int key, const ValueView& row) const
+{
+  if (!typed) {
+    fprintf(fp, "%d '%.*s'\n", key, row.length, row.data);
+    return;
+  }
+
+  fprintf(fp, "%d", key);
+  for (unsigned i = 1; i < columns.size(); i++) {
+    fputc(' ', fp);
+    printField(fp, i, row, true);
+  }
+  fputc('\n', fp);
+}
@@ -0,0 +1,189 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/17/2026
+ */
+
+#ifndef SCHEMA_H
+#define SCHEMA_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "Bruinbase.h"
+#include "TableFile.h"
+
+/**
+ * the typed columns of a table, declared by CREATE TABLE and kept in
+ * table.schema, one "name type length" line per column.
+ *
+ * the first column is the key of the table and must be an INT, so that
+ * tables with a schema are stored and indexed like any other. the other
+ * columns of a tuple are stored in its value as a binary row:
+ *  - a bitmap with a bit set for every column that is NULL,
+ *  - a slot for every column, in the order they were declared: 4 bytes
+ *    for an INT, 8 for a BIGINT or a DOUBLE, n bytes for a CHAR(n), padded
+ *    with NULs, and for a VARCHAR the offset and length of its bytes in
+ *    the row, 2 bytes each,
+ *  - the bytes of the VARCHAR columns.
+ * a column is read from the row where its slot is, without parsing the
+ * row or converting the column back to text.
+ *
+ * a table without a schema has two columns: key INT and value VARCHAR,
+ * whose value is the whole value of the tuple.
+ */
+class Schema {
+ public:
+  enum Type { INT = 0, BIGINT, DOUBLE, CHAR, VARCHAR };
+
+  // the longest row, so that offsets in the row fit in 2 bytes
+  static const int MAX_ROW_LENGTH = 65535;
+
+  // the longest CHAR column
+  static const int MAX_CHAR_LENGTH = 255;
+
+  /**
+   * a column of the table
+   */
+  struct Column {
+    std::string name;
+    Type        type;
+    int         length; // the declared length of a CHAR or VARCHAR, 0 otherwise
+    int         slot;   // where its slot is in a row; -1 for the key, or the value of a table without a schema
+  };
+
+  /**
+   * the constant a condition compares a column with, converted to the type
+   * of the column once, so that no tuple converts it again
+   */
+  struct Operand {
+    Type        type;    // the type of the column
+    int         slot;    // where the column is in a row (see Column)
+    int         bit;     // the bit of the column in the NULL bitmap
+    int         width;   // the length of a CHAR column
+    long long   integer; // the constant of an INT or BIGINT column
+    double      real;    // the constant of a DOUBLE column
+    const char* text;    // the constant of a CHAR or VARCHAR column
+    int         length;  // and its length
+  };
+
+  /**
+   * the schema of a table without one: key INT, value VARCHAR.
+   */
+  Schema();
+
+  /**
+   * add a column at the end of the schema of a new table.
+   * @param name[IN] the name of the column
+   * @param type[IN] the name of its type: int, bigint, double, char or varchar
+   * @param length[IN] the length of a char or varchar column; 0 if not given
+   * @return error code. RC_INVALID_SCHEMA if the column cannot be added
+   */
+  RC addColumn(const std::string& name, const std::string& type, int length);
+
+  /**
+   * read the schema of a table. a table without a schema file is given
+   * the schema of Schema().
+   * @param table[IN] the name of the table
+   * @return error code. 0 if no error
+   */
+  RC read(const std::string& table);
+
+  /**
+   * write the schema of a table to its schema file. the file is replaced
+   * as a whole and is on disk on return (see PageFile::replaceFile()).
+   * @param table[IN] the name of the table
+   * @return error code. 0 if no error
+   */
+  RC write(const std::string& table) const;
+
+  /**
+   * @param table[IN] the name of a table
+   * @return true if the table has a schema file
+   */
+  static bool exists(const std::string& table);
+
+  /**
+   * @return true if the columns are declared by CREATE TABLE, false for the
+   * schema of a table without one
+   */
+  bool isTyped() const { return typed; }
+
+  /**
+   * @return the # of columns, the key included
+   */
+  int columnCount() const { return (int)columns.size(); }
+
+  /**
+   * @param name[IN] the name of a column
+   * @return the index of the column, 0 for the key; -1 if there is none
+   */
+  int find(const std::string& name) const;
+
+  /**
+   * convert the constant of a condition to the type of a column.
+   * @param column[IN] the index of the column
+   * @param value[IN] the constant, as written in the condition; it must
+   * outlive the operand
+   * @param operand[OUT] the converted constant
+   * @return error code. RC_INVALID_ATTRIBUTE if the constant is not a
+   * value of the column
+   */
+  RC bind(int column, const char* value, Operand& operand) const;
+
+  /**
+   * compare a column of a row with the constant of a condition.
+   * @param operand[IN] the constant, bound to a column other than the key
+   * @param row[IN] the row
+   * @param diff[OUT] negative, 0 or positive as the column is less than,
+   * equal to or greater than the constant
+   * @return false if the column is NULL, true otherwise
+   */
+  static bool compare(const Operand& operand, const ValueView& row, int& diff);
+
+  /**
+   * parse a line from a load file into the key and the row of a tuple.
+   * the fields are separated by commas; a field may be quoted by ' or ",
+   * and \N stands for NULL.
+   * @param line[IN] a line from a load file
+   * @param key[OUT] the first field
+   * @param row[OUT] the other fields in binary form
+   * @return error code. RC_INVALID_FILE_FORMAT if the line does not match the schema
+   */
+  RC parseRow(const std::string& line, int& key, std::string& row) const;
+
+  /**
+   * print a column of a tuple followed by a newline.
+   * @param fp[IN] where to print
+   * @param column[IN] the index of the column
+   * @param key[IN] the key of the tuple
+   * @param row[IN] the value of the tuple
+   */
+  void printColumn(FILE* fp, int column, int key, const ValueView& row) const;
+
+  /**
+   * print every column of a tuple on a line, strings in quotes.
+   * @param fp[IN] where to print
+   * @param key[IN] the key of the tuple
+   * @param row[IN] the value of the tuple
+   */
+  void printRow(FILE* fp, int key, const ValueView& row) const;
+
+ private:
+  /**
+   * compute where the slot of each column is in a row.
+   */
+  void layout();
+
+  /**
+   * print a column other than the key of a row, strings in quotes if asked.
+   */
+  void printField(FILE* fp, int column, const ValueView& row, bool quote) const;
+
+  std::vector<Column> columns;
+  bool typed;         // whether the columns were declared by CREATE TABLE
+  int  fixedLength;   // # of bytes of a row before the bytes of its VARCHAR columns
+};
+
+#endif // SCHEMA_H
@@ -8,15 +8,19 @@
  */
 
 #include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <algorithm>
 #include "Bruinbase.h"
 #include "SqlEngine.h"
 #include "BTreeIndex.h"
+#include "WriteAheadLog.h"
 
 using namespace std;
 
+bool SqlEngine::coldCache = false;
+
 // external functions and variables for load file and sql command parsing 
 extern FILE* sqlin;
 int sqlparse(void);
@@ -65,32 +69,85 @@ RC SqlEngine::run(FILE* commandline)
   return 0;
 }
 
-RC SqlEngine::select(int attr, const string& table, const vector<SelCond>& cond)
+RC SqlEngine::select(const string& attribute, const string& table, const vector<SelCond>& conds)
 {
-  RecordFile rf;   // RecordFile containing the table
-  RecordId   rid;  // record cursor for table scanning
+  Schema     schema; // the columns of the table
+  RecordFile rf;   // RecordFile containing a table stored by rows
+  ColumnFile cf;   // ColumnFile containing a table stored by columns
+  TableFile* tf;   // whichever of the two holds the table
+  ZoneMap    zones; // the summaries of the pages of the table
+  RecordId   rid;  // record id of the current index entry
 
   BTreeIndex  index;  // Handle to the table's index
   IndexCursor cursor; // index cursor for table scanning
 
-  RC     rc;
-  int    key;     
-  string value;
-  int    count;
+  RC       rc;
+  int      attr;       // 1: key, 2: another column, 3: *, 4: count(*)
+  int      column = 0; // the column selected, for attr 2
+  int      key;     
+  ValueRef value; // the value of the current tuple, read in place
+  int      count;
 
   bool hasIndex   = true;
+  bool hasZones;
   bool finishScan = false;
-
+  bool readTable;     // whether tuples are read from the table
+  bool lateValues;    // whether values are read only for tuples passing the key conditions
+  bool valueRead;     // whether the value of the current tuple has been read
+  int  prefetched = 0; // # of upcoming index entries whose table pages were prefetched
+  bool prefetchedAll = false; // whether the prefetches reached the end of the scan
+  IndexCursor ahead;   // the first index entry not prefetched yet
+
+  vector<SelCond> cond(conds); // the conditions, bound to the columns of the table
   vector<SelCond> indexConds; // Conditions only on key, can get directly from index
   vector<SelCond> tableConds; // Conditions on value, requires reading table
 
+  if((rc = schema.read(table)) < 0) {
+    fprintf(stderr, "Error: cannot read the schema of table %s\n", table.c_str());
+    return rc;
+  }
+
+  // the attributes are columns of the table, and the values of the
+  // conditions are converted to their types once, here
+  if(attribute == "*") {
+    attr = 3;
+  } else if(attribute == "count(*)") {
+    attr = 4;
+  } else if((column = schema.find(attribute)) >= 0) {
+    attr = (column == 0) ? 1 : 2;
+  } else {
+    fprintf(stderr, "Error: table %s has no attribute %s\n", table.c_str(), attribute.c_str());
+    return RC_INVALID_ATTRIBUTE;
+  }
+
+  for(unsigned i = 0; i < cond.size(); i++) {
+    const int c = schema.find(cond[i].name);
+
+    if(c < 0) {
+      fprintf(stderr, "Error: table %s has no attribute %s\n", table.c_str(), cond[i].name);
+      return RC_INVALID_ATTRIBUTE;
+    }
+    if((rc = schema.bind(c, cond[i].value, cond[i].operand)) < 0) {
+      fprintf(stderr, "Error: '%s' is not a value of attribute %s\n", cond[i].value, cond[i].name);
+      return rc;
+    }
+    cond[i].attr = (c == 0) ? 1 : 2;
+  }
+
   if((rc = processConditions(attr, cond, indexConds, tableConds)) < 0) {
     fprintf(stderr, "Error processing conditions");
     return rc;
   }
 
   // open the table file
-  if ((rc = rf.open(table + ".tbl", 'r')) < 0) {
+  if (ColumnFile::exists(table)) {
+    tf = &cf;
+    rc = cf.open(table, 'r');
+  } else {
+    tf = &rf;
+    rc = rf.open(table + ".tbl", 'r');
+  }
+  if (rc < 0) {
     fprintf(stderr, "Error: table %s does not exist\n", table.c_str());
     return rc;
   }
@@ -109,8 +166,14 @@ RC SqlEngine::select(int attr, const string& table, const vector<SelCond>& cond)
     hasIndex = false;
   }
 
-  // open the table index
+  // open the table index. without one the table is scanned, but an index
+  // this build cannot read is reported rather than silently passed over
   if (hasIndex && (rc = index.open(table + ".idx", 'r')) < 0) {
+    if (rc == RC_INVALID_FILE_FORMAT) {
+      fprintf(stderr, "Error: index %s.idx is in a file format or page size this build cannot read; remove it to query the table without it\n", table.c_str());
+      tf->close();
+      return rc;
+    }
     hasIndex = false;
   }
 
@@ -120,58 +183,97 @@ RC SqlEngine::select(int attr, const string& table, const vector<SelCond>& cond)
     indexConds.clear();
   }
 
-  // init the cursor at an appropriate position
-  rid.pid = rid.sid = 0;
-  if(hasIndex) {
-    if(indexConds.size() > 0) {
-      switch(indexConds[0].comp) {
-        case SelCond::EQ:
-        case SelCond::GT:
-        case SelCond::GE:
-          rc = index.locate(atoi(indexConds[0].value), cursor);
-          break;
-        case SelCond::LT:
-        case SelCond::LE:
-        case SelCond::NE:
-        default:
-          rc = index.locateFirstEntry(cursor);
-          break;
-      }
-    } else { // no KEY conditions
-      rc = index.locateFirstEntry(cursor);
-    }
+  // the table is either scanned in order or probed through the index
+  tf->setAccessPattern(hasIndex ? PageFile::RANDOM : PageFile::SEQUENTIAL);
 
-    // Fetch the first tuple from the index
-    if(rc < 0 || (rc = index.readForward(cursor, key, rid)) < 0) {
-      fprintf(stderr, "Error while reading from index for table %s\n", table.c_str());
+  // without an index, the table is read a page at a time. the pages whose
+  // zones rule out every tuple are skipped, if the zones are those of the
+  // table as it is
+  if(!hasIndex) {
+    hasZones = (zones.open(table + ".zone", 'r') == 0);
+    if(hasZones && !zones.covers(tf->endRid())) {
+      zones.close();
+      hasZones = false;
+    }
+    rc = scanTable(attr, schema, column, table, *tf, hasZones ? &zones : NULL, tableConds, count);
+    if(hasZones)
+      zones.close();
+    if(rc < 0)
       goto exit_select;
+    goto print_count;
+  }
+
+  // init the cursor at an appropriate position
+  if(indexConds.size() > 0) {
+    switch(indexConds[0].comp) {
+      case SelCond::EQ:
+      case SelCond::GT:
+      case SelCond::GE:
+        rc = index.locate(atoi(indexConds[0].value), cursor);
+        break;
+      case SelCond::LT:
+      case SelCond::LE:
+      case SelCond::NE:
+      default:
+        rc = index.locateFirstEntry(cursor);
+        break;
     }
+  } else { // no KEY conditions
+    rc = index.locateFirstEntry(cursor);
+  }
+
+  // Fetch the first tuple from the index
+  if(rc < 0 || (rc = index.readForward(cursor, key, rid)) < 0) {
+    fprintf(stderr, "Error while reading from index for table %s\n", table.c_str());
+    goto exit_select;
   }
+  ahead = cursor;
+
+  // grab the key value pair from the table if we need to check or
+  // select on values
+  readTable = !tableConds.empty() || attr == 2 || attr == 3;
+
+  // the index already gave the key. a table stored by columns reads the
+  // value of a tuple only once its key passes the conditions on the key
+  // (tableConds has them first)
+  lateValues = (tf == &cf);
 
   count = 0;
   while (!finishScan) {
     // check the index conditions on the tuple
-    value = "";
     for(unsigned i = 0; i < indexConds.size(); i++) {
-      if(!matchesCondition(indexConds[i], key, value, finishScan))
+      if(!matchesCondition(indexConds[i], key, ValueView(), finishScan))
         goto next_tuple;
     }
 
-    // grab the key value pair from the table if no index is available,
-    // or if we need to check or select on values
-    if(!hasIndex || !tableConds.empty() || (hasIndex && (attr == 2 || attr == 3))) {
-      if ((rc = rf.read(rid, key, value)) < 0) {
-        fprintf(stderr, "Error: while reading a tuple from table %s\n", table.c_str());
-        goto exit_select;
-      }
+    // the value is read in place in the page of the tuple; the key is
+    // the one in the index
+    valueRead = readTable && !lateValues;
+    if(valueRead && (rc = tf->readValue(rid, value)) < 0) {
+      fprintf(stderr, "Error: while reading a tuple from table %s\n", table.c_str());
+      goto exit_select;
     }
 
     // check the table conditions on the tuple
     for (unsigned i = 0; i < tableConds.size(); i++) {
-      if(!matchesCondition(tableConds[i], key, value, finishScan))
+      if(tableConds[i].attr == 2 && !valueRead) {
+        if((rc = tf->readValue(rid, value)) < 0) {
+          fprintf(stderr, "Error: while reading a tuple from table %s\n", table.c_str());
+          goto exit_select;
+        }
+        valueRead = true;
+      }
+      if(!matchesCondition(tableConds[i], key, value.value, finishScan))
         goto next_tuple;
     }
 
+    if((attr == 2 || attr == 3) && !valueRead) {
+      if((rc = tf->readValue(rid, value)) < 0) {
+        fprintf(stderr, "Error: while reading a tuple from table %s\n", table.c_str());
+        goto exit_select;
+      }
+    }
+
     // the condition is met for the tuple. 
     // increase matching tuple counter
     count++;
@@ -181,34 +283,41 @@ RC SqlEngine::select(int attr, const string& table, const vector<SelCond>& cond)
     case 1:  // SELECT key
       fprintf(stdout, "%d\n", key);
       break;
-    case 2:  // SELECT value
-      fprintf(stdout, "%s\n", value.c_str());
+    case 2:  // SELECT value, or another column
+      schema.printColumn(stdout, column, key, value.value);
       break;
     case 3:  // SELECT *
-      fprintf(stdout, "%d '%s'\n", key, value.c_str());
+      schema.printRow(stdout, key, value.value);
       break;
     }
 
     // move to the next tuple
     next_tuple:
 
-    if(hasIndex) {
-      // otherwise continue reading
-      rc = index.readForward(cursor, key, rid);
+    // the page of the value is not needed anymore
+    value.clear();
 
-      // exit on end of tree or unknown errors
-      if(rc == RC_END_OF_TREE) {
-        break;
-      } else if(rc < 0) {
-        fprintf(stderr, "Error while reading from index for table %s\n", table.c_str());
-        goto exit_select;
-      }
-    } else { // no index, read from table directly
-      finishScan = ++rid >= rf.endRid();
+    // get the table pages of the upcoming entries on their way together.
+    // a batch shorter than PREFETCH_BATCH reached the end of the scan
+    if(readTable && !prefetchedAll && --prefetched <= 0) {
+      prefetched = prefetchRecords(index, ahead, indexConds, *tf);
+      prefetchedAll = (prefetched < PREFETCH_BATCH);
+    }
+
+    // otherwise continue reading
+    rc = index.readForward(cursor, key, rid);
+
+    // exit on end of tree or unknown errors
+    if(rc == RC_END_OF_TREE) {
+      break;
+    } else if(rc < 0) {
+      fprintf(stderr, "Error while reading from index for table %s\n", table.c_str());
+      goto exit_select;
     }
   }
 
   // print matching tuple count if "select count(*)"
+  print_count:
   if (attr == 4) {
     fprintf(stdout, "%d\n", count);
   }
@@ -216,21 +325,217 @@ RC SqlEngine::select(int attr, const string& table, const vector<SelCond>& cond)
 
   // close the table file and return
   exit_select:
-  rf.close();
+  tf->close();
   index.close();
   return rc;
 }
 
-RC SqlEngine::load(const string& table, const string& loadfile, bool index)
+RC SqlEngine::scanTable(int attr, const Schema& schema, int column, const string& table, TableFile& tf, const ZoneMap* zones, const vector<SelCond>& conds, int& count)
+{
+  ScanBatch        batch;       // the tuples of the current page
+  RecordId         rid;         // where the scan is
+  ZoneMap::Zone    zone;        // the summary of a page
+  vector<RecordId> pages;       // the pages of the current window not ruled out by their zones
+  unsigned         next = 0;    // the next of them to read
+  PageId           zoned = 0;   // the first page whose zone is not checked yet
+  int              skipped = 0; // # of pages ruled out by their zones so far
+  PageFile::AccessPattern pattern;                            // how the pages of the window are read
+  PageFile::AccessPattern readPattern = PageFile::SEQUENTIAL; // how the table is read
+  vector<int>      bounds;      // the bounds of conds in the dictionary of the batch
+  bool             needValues = (attr == 2 || attr == 3);
+  bool             selective = false; // whether a condition may rule out a page
+  bool             valuesRead;
+  bool             terminate;
+  RC               rc;
+
+  for(unsigned i = 0; i < conds.size(); i++) {
+    if(conds[i].attr == 2) needValues = true;
+    if(conds[i].comp != SelCond::NE && (conds[i].attr == 1 || conds[i].operand.slot < 0)) selective = true;
+  }
+
+  // zones only rule out pages for conditions other than <>, on the key or
+  // on the whole value
+  if(!selective)
+    zones = NULL;
+
+  count = 0;
+  rid.pid = rid.sid = 0;
+  for(;;) {
+    batch.clear();
+
+    // check the zones of the next ZONE_WINDOW pages. the pages they do not
+    // rule out are not in order, and are prefetched together instead of
+    // read ahead, unless none was ruled out
+    while(zones != NULL && next == pages.size()) {
+      pages.clear();
+      next = 0;
+      rid.sid = 0;
+      for(rid.pid = zoned; rid.pid < zoned + ZONE_WINDOW && zones->getZone(rid.pid, zone) == 0; rid.pid++) {
+        if(zoneMatches(zone, conds))
+          pages.push_back(rid);
+        else
+          skipped++;
+      }
+      pattern = ((PageId)pages.size() < rid.pid - zoned) ? PageFile::RANDOM : PageFile::SEQUENTIAL;
+      if(pattern != readPattern)
+        tf.setAccessPattern(readPattern = pattern);
+      if(pattern == PageFile::RANDOM)
+        tf.prefetch(pages);
+
+      // past the last zone, or once the zones have saved fewer pages than
+      // they took to read, the rest of the table is read in order
+      if(rid.pid < zoned + ZONE_WINDOW
+         || (rid.pid >= ZONE_TRIAL_PAGES && skipped * ZoneMap::ZONES_PER_PAGE < rid.pid)) {
+        zones = NULL;
+        if(readPattern != PageFile::SEQUENTIAL)
+          tf.setAccessPattern(readPattern = PageFile::SEQUENTIAL);
+      }
+      zoned = rid.pid;
+    }
+
+    if(next < pages.size()) {
+      rid = pages[next++];
+    } else if(rid.pid < zoned) {
+      rid.pid = zoned;
+      rid.sid = 0;
+    }
+
+    if((rc = tf.nextBatch(rid, batch)) < 0)
+      break;
+
+    // the values are read once a tuple of the page passes the conditions
+    // on the key (conds has them first)
+    valuesRead = false;
+
+    for(int i = 0; i < batch.count; i++) {
+      const int key = batch.keys[i];
+
+      for(unsigned j = 0; j < conds.size(); j++) {
+        if(conds[j].attr == 2 && !valuesRead) {
+          if((rc = tf.readValues(batch)) < 0)
+            goto scan_failed;
+          if(!batch.codes.empty())
+            codeBounds(batch.dict, conds, bounds);
+          valuesRead = true;
+        }
+
+        // values with a dictionary are compared by their codes
+        if(conds[j].attr == 2 && conds[j].operand.slot < 0 && !batch.codes.empty()) {
+          if(!matchesCode(conds[j], batch.codes[i], bounds[j], terminate))
+            goto next_tuple;
+        } else if(!matchesCondition(conds[j], key, (conds[j].attr == 2) ? batch.values[i] : ValueView(), terminate)) {
+          goto next_tuple;
+        }
+      }
+
+      if(needValues && !valuesRead) {
+        if((rc = tf.readValues(batch)) < 0)
+          goto scan_failed;
+        valuesRead = true;
+      }
+
+      // the condition is met for the tuple. 
+      // increase matching tuple counter
+      count++;
+
+      // print the tuple 
+      switch (attr) {
+      case 1:  // SELECT key
+        fprintf(stdout, "%d\n", key);
+        break;
+      case 2:  // SELECT value, or another column
+        schema.printColumn(stdout, column, key, batch.values[i]);
+        break;
+      case 3:  // SELECT *
+        schema.printRow(stdout, key, batch.values[i]);
+        break;
+      }
+
+      next_tuple:
+      ;
+    }
+  }
+
+  if(rc == RC_NO_SUCH_RECORD)
+    return 0;
+
+  scan_failed:
+  fprintf(stderr, "Error: while reading a tuple from table %s\n", table.c_str());
+  return rc;
+}
+
+bool SqlEngine::zoneMatches(const ZoneMap::Zone& zone, const vector<SelCond>& conds)
+{
+  if(zone.count == 0)
+    return false;
+
+  for(unsigned i = 0; i < conds.size(); i++) {
+    if(conds[i].attr == 1) {
+      const int key = (int)conds[i].operand.integer;
+
+      switch(conds[i].comp) {
+        case SelCond::EQ:
+          if(key < zone.minKey || key > zone.maxKey) return false;
+          break;
+        case SelCond::NE:
+          if(key == zone.minKey && key == zone.maxKey) return false;
+          break;
+        case SelCond::GT:
+          if(zone.maxKey <= key) return false;
+          break;
+        case SelCond::GE:
+          if(zone.maxKey < key) return false;
+          break;
+        case SelCond::LT:
+          if(zone.minKey >= key) return false;
+          break;
+        case SelCond::LE:
+          if(zone.minKey > key) return false;
+          break;
+      }
+    } else if(conds[i].operand.slot < 0) {
+      const string value = conds[i].value;
+
+      switch(conds[i].comp) {
+        case SelCond::EQ:
+          if(!zone.mayBeLess(value, true) || !zone.mayBeGreater(value, true) || !zone.mayContain(value)) return false;
+          break;
+        case SelCond::NE:
+          break;
+        case SelCond::GT:
+          if(!zone.mayBeGreater(value, false)) return false;
+          break;
+        case SelCond::GE:
+          if(!zone.mayBeGreater(value, true)) return false;
+          break;
+        case SelCond::LT:
+          if(!zone.mayBeLess(value, false)) return false;
+          break;
+        case SelCond::LE:
+          if(!zone.mayBeLess(value, true)) return false;
+          break;
+      }
+    }
+  }
+
+  return true;
+}
+
+RC SqlEngine::load(const string& table, const string& loadfile, bool index, bool columns)
 {
   // Status variables
   RC          rc = 0;
   RC          rfCloseStatus;
+  RC          zoneCloseStatus;
   RC          indexCloseStatus;
 
   // File handles
   ifstream    lfs;
+  Schema      schema;
   RecordFile  rf;
+  ColumnFile  cf;
+  TableFile*  tf;
+  ZoneMap     zones;
 
   // Buffer for reading from loadfile
   string      line;
@@ -238,7 +543,11 @@ RC SqlEngine::load(const string& table, const string& loadfile, bool index)
   // Values for inserting into the table
   int         key;
   string      value;
-  RecordId    rid;
+  vector<int>      keys;
+  vector<string>   values;
+  vector<RecordId> rids;
+  RC          status;
+  bool        done = false; // an empty line ends the load file
 
   // Index handle
   BTreeIndex  dbIndex;
@@ -252,39 +561,95 @@ RC SqlEngine::load(const string& table, const string& loadfile, bool index)
     return RC_FILE_OPEN_FAILED;
   }
 
+  // the lines of a table with a schema are parsed into binary rows
+  if((rc = schema.read(table)) < 0) {
+    fprintf(stderr, "Error: cannot read the schema of table %s\n", table.c_str());
+    return rc;
+  }
+
   if(index && (rc = dbIndex.open((table + ".idx").c_str(), 'w')) < 0) {
     fprintf(stderr, "Error opening index for table %s\n", table.c_str());
     return rc;
   }
 
-  if((rc = rf.open((table + ".tbl").c_str(), 'w')) < 0) {
+  // rows are appended to an existing table in the layout it already has
+  if(ColumnFile::exists(table) || (columns && !ifstream((table + ".tbl").c_str()).good())) {
+    tf = &cf;
+    rc = cf.open(table, 'w');
+  } else {
+    tf = &rf;
+    rc = rf.open((table + ".tbl").c_str(), 'w');
+  }
+  if(rc < 0) {
     fprintf(stderr, "Error record file for table %s\n", table.c_str());
     return rc;
   }
 
+  // the zones of the pages written are built as they are written; those
+  // of a table loaded without them (or since changed) are built first
+  if((rc = zones.open(table + ".zone", 'w')) < 0
+     || (!zones.covers(tf->endRid()) && (rc = zones.summarize(*tf, 0, tf->endRid().pid)) < 0)) {
+    fprintf(stderr, "Error opening the zone map for table %s\n", table.c_str());
+    zones.close();
+    tf->close();
+    return rc;
+  }
+
   parseLine = 0;
-  while(!lfs.eof()) {
-    getline(lfs, line);
+  while(rc == 0 && !lfs.eof()) {
+    // parse a batch of rows, whose table pages are then written together
+    keys.clear();
+    values.clear();
+    while((int)keys.size() < LOAD_BATCH && !lfs.eof()) {
+      getline(lfs, line);
+
+      if(line == "") {
+        done = true;
+        break;
+      }
 
-    if(line == "")
-      break;
+      if((rc = schema.isTyped() ? schema.parseRow(line, key, value) : parseLoadLine(line, key, value)) < 0) {
+        fprintf(stderr, "Error while parsing from loadfile %s at line %i\n", loadfile.c_str(), parseLine + (unsigned)keys.size());
+        break;
+      }
 
-    if((rc = parseLoadLine(line, key, value)) < 0) {
-      fprintf(stderr, "Error while parsing from loadfile %s at line %i\n", loadfile.c_str(), parseLine);
-      break;
+      keys.push_back(key);
+      values.push_back(value);
     }
 
-    if((rc = rf.append(key, value, rid)) < 0) {
+    // the rows parsed before an error are still loaded
+    if((status = tf->appendBatch(keys, values, rids)) < 0) {
       fprintf(stderr, "Error appending data to table %s\n", table.c_str());
+      rc = status;
       break;
     }
 
-    if(index && (rc = dbIndex.insert(key, rid)) < 0) {
-      fprintf(stderr, "Error inserting data to index for table %s\n", table.c_str());
+    if(!rids.empty() && (status = zones.summarize(*tf, rids.front().pid, rids.back().pid)) < 0) {
+      fprintf(stderr, "Error building the zone map for table %s\n", table.c_str());
+      rc = status;
       break;
     }
 
-    parseLine++;
+    for(unsigned i = 0; index && i < rids.size(); i++) {
+      if((status = dbIndex.insert(keys[i], rids[i])) < 0) {
+        fprintf(stderr, "Error inserting data to index for table %s\n", table.c_str());
+        rc = status;
+        break;
+      }
+    }
+    if(rc < 0)
+      break;
+
+    parseLine += (unsigned)keys.size();
+
+    // make the rows loaded so far durable; one sync covers many rows
+    if(parseLine % COMMIT_ROWS == 0 && (rc = WriteAheadLog::commit()) < 0) {
+      fprintf(stderr, "Error committing the load of table %s\n", table.c_str());
+      break;
+    }
+
+    if(done)
+      break;
   }
 
   try {
@@ -293,12 +658,135 @@ RC SqlEngine::load(const string& table, const string& loadfile, bool index)
     rc = RC_FILE_CLOSE_FAILED;
   }
 
-  if((rfCloseStatus = rf.close()) < 0)
+  // the zones are only used once they cover every row of the table
+  if(rc < 0)
+    zones.close();
+  else if((zoneCloseStatus = zones.close(tf->endRid())) < 0)
+    rc = zoneCloseStatus;
+
+  if((rfCloseStatus = tf->close()) < 0)
     return rfCloseStatus;
 
   if(index && (indexCloseStatus = dbIndex.close()) < 0)
     return indexCloseStatus;
 
+  // the rows are durable once load returns
+  if(rc == 0)
+    rc = WriteAheadLog::commit();
+
+  return rc;
+}
+
+RC SqlEngine::create(const string& table, const vector<ColumnDef>& columns)
+{
+  Schema     schema;
+  RecordFile rf;
+  RC         rc;
+
+  if(Schema::exists(table) || ColumnFile::exists(table) || ifstream((table + ".tbl").c_str()).good()) {
+    fprintf(stderr, "Error: table %s already exists\n", table.c_str());
+    return RC_INVALID_SCHEMA;
+  }
+
+  for(unsigned i = 0; i < columns.size(); i++) {
+    if((rc = schema.addColumn(columns[i].name, columns[i].type, columns[i].length)) < 0) {
+      fprintf(stderr, "Error: invalid column %s of table %s\n", columns[i].name, table.c_str());
+      return rc;
+    }
+  }
+
+  // the schema goes first, so that a table is never loaded without it
+  if((rc = schema.write(table)) < 0) {
+    fprintf(stderr, "Error: cannot write the schema of table %s\n", table.c_str());
+    return rc;
+  }
+
+  if((rc = rf.open(table + ".tbl", 'w')) < 0 || (rc = rf.close()) < 0) {
+    fprintf(stderr, "Error: cannot create table %s\n", table.c_str());
+    return rc;
+  }
+
+  return WriteAheadLog::commit();
+}
+
+RC SqlEngine::showStats()
+{
+  vector<int> fids;
+  vector<const FileStats*> files;
+  char readLatency[32], writeLatency[32];
+
+  FileStats::list(fids, files);
+
+  fprintf(stdout, "%-16s %8s %8s %8s %8s %8s %10s %10s %15s %15s\n", "file",
+          "reads", "writes", "hits", "misses", "evicted", "KB read", "KB written", "read us p50/99", "write us p50/99");
+  for (unsigned i = 0; i < files.size(); i++) {
+    const FileStats* f = files[i];
+    BufferPool::FileCounters c = PageFile::getCacheCounters(fids[i]);
+
+    snprintf(readLatency, sizeof(readLatency), "%lld/%lld", f->readLatency.percentile(0.5), f->readLatency.percentile(0.99));
+    snprintf(writeLatency, sizeof(writeLatency), "%lld/%lld", f->writeLatency.percentile(0.5), f->writeLatency.percentile(0.99));
+    fprintf(stdout, "%-16s %8lld %8lld %8lld %8lld %8lld %10lld %10lld %15s %15s\n", f->name.c_str(),
+            (long long)f->reads, (long long)f->writes, c.hits, c.misses, c.evictions,
+            (long long)f->bytesRead / 1024, (long long)f->bytesWritten / 1024, readLatency, writeLatency);
+  }
+  fprintf(stdout, "page cache: %zu KB, %s, %lld hits, %lld misses\n", PageFile::getCacheSize() / 1024,
+          PageFile::getCachePolicy(), PageFile::getCacheHitCount(), PageFile::getCacheMissCount());
+  if (WriteAheadLog::isOpen()) {
+    fprintf(stdout, "log: %lld records, %lld absorbed, %lld commits, %lld syncs, %lld checkpoints\n",
+            WriteAheadLog::getRecordCount(), WriteAheadLog::getAbsorbedCount(), WriteAheadLog::getCommitCount(),
+            WriteAheadLog::getSyncCount(), WriteAheadLog::getCheckpointCount());
+  }
+
+  return 0;
+}
+
+RC SqlEngine::prewarm(const string& table)
+{
+  RecordFile rf;
+  ColumnFile cf;
+  TableFile* tf;
+  BTreeIndex index;
+  RC  rc;
+  int budget = (int)(PageFile::getCacheSize() / PageFile::PAGE_SIZE);
+  int count;
+
+  if (ColumnFile::exists(table)) {
+    tf = &cf;
+    rc = cf.open(table, 'r');
+  } else {
+    tf = &rf;
+    rc = rf.open(table + ".tbl", 'r');
+  }
+  if (rc < 0) {
+    fprintf(stderr, "Error: table %s does not exist\n", table.c_str());
+    return rc;
+  }
+
+  // the upper levels of the index are what every lookup reads first
+  if (index.open(table + ".idx", 'r') == 0) {
+    int height;
+    if ((rc = index.getHeight(height)) == 0) rc = index.prewarm(budget, count);
+    index.close();
+    if (rc == 0) {
+      fprintf(stderr, "  -- the index of %s is %d levels high, %d of its pages were prewarmed\n", table.c_str(), height, count);
+      budget -= count;
+    }
+  }
+
+  // the rest of the cache goes to the table
+  if (rc == 0) rc = tf->prewarm(budget, count);
+  tf->close();
+
+  return rc;
+}
+
+RC SqlEngine::saveCache()
+{
+  RC rc;
+
+  if ((rc = PageFile::saveCache(PageFile::CACHE_FILE)) < 0) {
+    fprintf(stderr, "Error: cannot write %s\n", PageFile::CACHE_FILE);
+  }
   return rc;
 }
 
@@ -399,33 +887,81 @@ RC SqlEngine::processConditions(const int attr, const vector<SelCond>& conds, ve
 }
 
 /**
- * Determines if a key and value pair satisfy a given condition
+ * Determines if a key and a value read in place satisfy a given condition
  * @param cond[IN] the condition to check against
  * @param key[IN] the key to check
  * @param value[IN] the value to check
  * @param terminate[OUT] indicates a possible early termination (i.e. if this condition is applied to the index)
  * @return true if the condition is matched, false otherwise
  */
-bool SqlEngine::matchesCondition(const SelCond &cond, const int key, const string& value, bool& terminate) {
-  int diff;
-  bool match = false;
+bool SqlEngine::matchesCondition(const SelCond &cond, const int key, const ValueView& value, bool& terminate) {
+  int  diff;
+  int  length;
+  bool match;
 
   terminate = false;
 
   // compute the difference between the tuple value and the condition value
   switch (cond.attr) {
   case 1:
-    diff = key - atoi(cond.value);
+    diff = (key > cond.operand.integer) - (key < cond.operand.integer);
     break;
-  case 2: diff = strcmp(value.c_str(), cond.value);
+  case 2:
+    // a column of a table with a schema is compared in its own type,
+    // where it is in the value. a NULL matches no condition
+    if (cond.operand.slot >= 0) {
+      if (!Schema::compare(cond.operand, value, diff)) return false;
+      break;
+    }
+
+    // the same order as strcmp(): bytes as unsigned, then the shorter first
+    length = cond.operand.length;
+    diff = memcmp(value.data, cond.value, min(value.length, length));
+    if (diff == 0) diff = value.length - length;
     break;
   default:
     return false;
     break;
   }
 
+  match = matchesComparator(cond.comp, diff, terminate);
+
+  // an index scan is in key order: only a condition on the key ends it
+  if (cond.attr != 1) terminate = false;
+
+  return match;
+}
+
+/**
+ * Determines if the value of a tuple of a table stored by columns
+ *    satisfies a condition, comparing the code of the value with the
+ *    bound of the condition in the dictionary of the block of the tuple
+ * @param cond[IN] the condition on the value to check against
+ * @param code[IN] the code of the value
+ * @param bound[IN] the bound of the condition (see codeBounds())
+ * @param terminate[OUT] indicates a possible early termination
+ * @return true if the condition is matched, false otherwise
+ */
+bool SqlEngine::matchesCode(const SelCond& cond, const int code, const int bound, bool& terminate) {
+  // codes follow the order of the values, so no string is compared
+  return matchesComparator(cond.comp, code - bound, terminate);
+}
+
+/**
+ * Determines if a comparison of two keys, values or codes satisfies
+ *    the comparator of a condition
+ * @param comp[IN] the comparator of the condition
+ * @param diff[IN] the difference of the tuple and the condition operands
+ * @param terminate[OUT] indicates a possible early termination
+ * @return true if the condition is matched, false otherwise
+ */
+bool SqlEngine::matchesComparator(const SelCond::Comparator comp, const int diff, bool& terminate) {
+  bool match = false;
+
+  terminate = false;
+
   // skip the tuple if any condition is not met
-  switch (cond.comp) {
+  switch (comp) {
     case SelCond::EQ: match = diff == 0; terminate = !match; break;
     case SelCond::NE: match = diff != 0; terminate =  false; break;
     case SelCond::GT: match = diff >  0; terminate =  false; break;
@@ -436,3 +972,79 @@ bool SqlEngine::matchesCondition(const SelCond &cond, const int key, const strin
 
   return match;
 }
+
+/**
+ * Translates the conditions on the value into bounds on the codes of
+ *    a dictionary: a value satisfies a condition exactly when its code
+ *    compared with the bound does
+ * @param dict[IN] the sorted values of a block of a table stored by columns
+ * @param conds[IN] the conditions
+ * @param bounds[OUT] the bound of each condition on the value
+ */
+void SqlEngine::codeBounds(const vector<string>& dict, const vector<SelCond>& conds, vector<int>& bounds) {
+  bounds.assign(conds.size(), 0);
+
+  for(unsigned i = 0; i < conds.size(); i++) {
+    if(conds[i].attr != 2 || conds[i].operand.slot >= 0)
+      continue;
+
+    // the first value of the dictionary that is not less than the operand
+    int  lower = (int)(lower_bound(dict.begin(), dict.end(), string(conds[i].value)) - dict.begin());
+    bool found = lower < (int)dict.size() && dict[lower] == conds[i].value;
+
+    switch(conds[i].comp) {
+      case SelCond::EQ:
+      case SelCond::NE:
+        // no code is equal to a value missing from the dictionary
+        bounds[i] = found ? lower : -1;
+        break;
+      case SelCond::LT:
+      case SelCond::GE:
+        bounds[i] = lower;
+        break;
+      case SelCond::LE:
+      case SelCond::GT:
+        // the last code not greater than the operand
+        bounds[i] = found ? lower : lower - 1;
+        break;
+    }
+  }
+}
+
+/**
+ * Reads ahead of an index scan: collects the records of the next index
+ *    entries that satisfy the index conditions, and reads their table
+ *    pages into the page cache with one batch of reads
+ * @param index[IN] the index being scanned
+ * @param cursor[IN/OUT] the first entry not prefetched yet; moved past
+ *    the entries covered, so that the next batch continues from there
+ * @param indexConds[IN] the conditions on the key
+ * @param tf[IN] the table the records are read from
+ * @return the number of index entries covered
+ */
+int SqlEngine::prefetchRecords(const BTreeIndex& index, IndexCursor& cursor, const vector<SelCond>& indexConds, const TableFile& tf) {
+  vector<RecordId> rids;
+  RecordId rid;
+  int      key;
+  int      n;
+  bool     finish = false;
+
+  for(n = 0; n < PREFETCH_BATCH && !finish; n++) {
+    if(index.readForward(cursor, key, rid) < 0)
+      break;
+
+    // skip the entries the scan is going to reject anyway
+    unsigned i;
+    for(i = 0; i < indexConds.size(); i++) {
+      if(!matchesCondition(indexConds[i], key, ValueView(), finish))
+        break;
+    }
+    if(i == indexConds.size())
+      rids.push_back(rid);
+  }
+
+  // this is only a hint; the scan reads the pages itself if it fails
+  tf.prefetch(rids);
+
+  return n;
+}
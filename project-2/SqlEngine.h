@@ -13,14 +13,29 @@
 #include <vector>
 #include "Bruinbase.h"
 #include "RecordFile.h"
+#include "ColumnFile.h"
+#include "ZoneMap.h"
+#include "Schema.h"
+#include "BTreeIndex.h"
 
 /**
  * data structure to represent a condition in the WHERE clause
  */
 struct SelCond {
-  int attr;     // attribute: 1 - key column,  2 - value column
+  int attr;     // attribute: 1 - key column,  2 - value column (or another column of a table with a schema)
   enum Comparator { EQ = 0, GT, GE, LT, LE, NE, } comp; // ordered by "selectiveness"
   char* value;  // the value to compare
+  char* name;   // the name of the attribute
+  Schema::Operand operand; // the value in the type of the attribute, set by SqlEngine::select()
+};
+
+/**
+ * data structure to represent a column in a CREATE TABLE statement
+ */
+struct ColumnDef {
+  char* name;   // the name of the column
+  char* type;   // the name of its type
+  int length;   // the length in parentheses after the type; 0 if none
 };
 
 /**
@@ -43,21 +58,32 @@ class SqlEngine {
    * all conditions in conds must be ANDed together.
    * the result of the SELECT is printed on screen.
    * @param attr[IN] attribute in the SELECT clause
-   * (1: key, 2: value, 3: *, 4: count(*))
+   * (the name of a column, "*" or "count(*)")
    * @param table[IN] the table name in the FROM clause
    * @param conds[IN] list of conditions in the WHERE clause
    * @return error code. 0 if no error
    */
-  static RC select(int attr, const std::string& table, const std::vector<SelCond>& conds);
+  static RC select(const std::string& attr, const std::string& table, const std::vector<SelCond>& conds);
+
+  /**
+   * executes a CREATE TABLE statement: records the columns of a new table
+   * in its schema (see Schema), and creates it empty.
+   * @param table[IN] the table name in the CREATE TABLE command
+   * @param columns[IN] the columns of the table, the key first
+   * @return error code. 0 if no error
+   */
+  static RC create(const std::string& table, const std::vector<ColumnDef>& columns);
 
   /**
    * load a table from a load file.
    * @param table[IN] the table name in the LOAD command
    * @param loadfile[IN] the file name of the load file
    * @param index[IN] true if "WITH INDEX" option was specified
+   * @param columns[IN] true if "WITH COLUMNS" option was specified, to store
+   * a new table by columns (see ColumnFile). an existing table keeps its layout
    * @return error code. 0 if no error
    */
-  static RC load(const std::string& table, const std::string& loadfile, bool index);
+  static RC load(const std::string& table, const std::string& loadfile, bool index, bool columns);
 
   /**
    * parse a line from the load file into the (key, value) pair.
@@ -68,8 +94,71 @@ class SqlEngine {
    */
   static RC parseLoadLine(const std::string& line, int& key, std::string& value);
 
+  /**
+   * executes a SHOW STATS statement: prints the I/O counters of every
+   * file opened so far (pages read and written, page cache hits, misses
+   * and evictions, bytes moved and latency percentiles) on screen.
+   * @return error code. 0 if no error
+   */
+  static RC showStats();
+
+  /**
+   * executes a PREWARM statement: reads the upper levels of the index of
+   * the table into the page cache, then as many of its first table pages
+   * as the rest of the cache holds. the height of the index is printed
+   * on screen.
+   * @param table[IN] the table name in the PREWARM command
+   * @return error code. 0 if no error
+   */
+  static RC prewarm(const std::string& table);
+
+  /**
+   * executes a SAVE CACHE statement: records the pages held in the page
+   * cache to PageFile::CACHE_FILE, to be read back by a later process.
+   * @return error code. 0 if no error
+   */
+  static RC saveCache();
+
+  /**
+   * measure SELECT statements from a cold cache: the page cache is
+   * emptied before each of them runs.
+   * @param cold[IN] true to empty the cache before each SELECT
+   */
+  static void setColdCache(bool cold) { coldCache = cold; }
+
+  /**
+   * @return true if the page cache is emptied before each SELECT
+   */
+  static bool getColdCache() { return coldCache; }
+
 private:
 
+  /**
+   * Scans the whole table for a SELECT without an index: reads the tuples
+   *    a page at a time, and the values of a page only if a tuple of the
+   *    page passes the conditions on the key. the pages whose zones rule
+   *    out every tuple are not read at all
+   * @param attr[IN] the type of select query being processed
+   * @param schema[IN] the schema of the table
+   * @param column[IN] the column selected, for attr 2
+   * @param table[IN] the table name, for error messages
+   * @param tf[IN] the table
+   * @param zones[IN] the zones of the pages of the table, or NULL
+   * @param conds[IN] the conditions, those on the key first
+   * @param count[OUT] the number of tuples matching the conditions
+   * @return 0 on success, an error code otherwise
+   */
+  static RC scanTable(int attr, const Schema& schema, int column, const std::string& table, TableFile& tf, const ZoneMap* zones, const std::vector<SelCond>& conds, int& count);
+
+  /**
+   * Determines if any tuple of a page may satisfy all the conditions,
+   *    given the summary of the page
+   * @param zone[IN] the zone of the page
+   * @param conds[IN] the conditions to check against
+   * @return false if no tuple of the page can match, true otherwise
+   */
+  static bool zoneMatches(const ZoneMap::Zone& zone, const std::vector<SelCond>& conds);
+
   /**
    * Filters out conditions into two types: those that can be resolved
    *    using only an index, and those that require reading the table itself
@@ -82,14 +171,78 @@ private:
   static RC processConditions(const int attr, const std::vector<SelCond>& conds, std::vector<SelCond>& indexConds, std::vector<SelCond>& tableConds);
 
   /**
-   * Determines if a key and value pair satisfy a given condition
+   * Determines if a key and a value read in place satisfy a given condition
    * @param cond[IN] the condition to check against
    * @param key[IN] the key to check
    * @param value[IN] the value to check
    * @param terminate[OUT] indicates a possible early termination (i.e. if this condition is applied to the index)
    * @return true if the condition is matched, false otherwise
    */
-  static bool matchesCondition(const SelCond& cond, const int key, const std::string& value, bool& terminate);
+  static bool matchesCondition(const SelCond& cond, const int key, const ValueView& value, bool& terminate);
+
+  /**
+   * Determines if the value of a tuple of a table stored by columns
+   *    satisfies a condition, comparing the code of the value with the
+   *    bound of the condition in the dictionary of the block of the tuple
+   * @param cond[IN] the condition on the value to check against
+   * @param code[IN] the code of the value
+   * @param bound[IN] the bound of the condition (see codeBounds())
+   * @param terminate[OUT] indicates a possible early termination
+   * @return true if the condition is matched, false otherwise
+   */
+  static bool matchesCode(const SelCond& cond, const int code, const int bound, bool& terminate);
+
+  /**
+   * Determines if a comparison of two keys, values or codes satisfies
+   *    the comparator of a condition
+   * @param comp[IN] the comparator of the condition
+   * @param diff[IN] the difference of the tuple and the condition operands
+   * @param terminate[OUT] indicates a possible early termination
+   * @return true if the condition is matched, false otherwise
+   */
+  static bool matchesComparator(const SelCond::Comparator comp, const int diff, bool& terminate);
+
+  /**
+   * Translates the conditions on the value into bounds on the codes of
+   *    a dictionary: a value satisfies a condition exactly when its code
+   *    compared with the bound does
+   * @param dict[IN] the sorted values of a block of a table stored by columns
+   * @param conds[IN] the conditions
+   * @param bounds[OUT] the bound of each condition on the value
+   */
+  static void codeBounds(const std::vector<std::string>& dict, const std::vector<SelCond>& conds, std::vector<int>& bounds);
+
+  /**
+   * Reads ahead of an index scan: collects the records of the next index
+   *    entries that satisfy the index conditions, and reads their table
+   *    pages into the page cache with one batch of reads
+   * @param index[IN] the index being scanned
+   * @param cursor[IN/OUT] the first entry not prefetched yet; moved past
+   *    the entries covered, so that the next batch continues from there
+   * @param indexConds[IN] the conditions on the key
+   * @param tf[IN] the table the records are read from
+   * @return the number of index entries covered
+   */
+  static int prefetchRecords(const BTreeIndex& index, IndexCursor& cursor, const std::vector<SelCond>& indexConds, const TableFile& tf);
+
+  // # of index entries covered by one prefetchRecords()
+  static const int PREFETCH_BATCH = 64;
+
+  // # of rows a LOAD appends to the table at a time
+  static const int LOAD_BATCH = 1000;
+
+  // # of rows a LOAD appends between commits of the write-ahead log.
+  // a multiple of LOAD_BATCH
+  static const int COMMIT_ROWS = 100000;
+
+  // # of pages whose zones a scan checks at a time
+  static const int ZONE_WINDOW = 64;
+
+  // # of pages after which a scan gives up on zones that have saved
+  // fewer pages than they took to read
+  static const int ZONE_TRIAL_PAGES = 128;
+
+  static bool coldCache; // whether SELECTs start from an empty page cache
 };
 
 #endif /* SQLENGINE_H */
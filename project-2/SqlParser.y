@@ -12,11 +12,15 @@ int  sqllex(void);
 void sqlerror(const char *str) { fprintf(stderr, "Error: %s\n", str); }
 extern "C" { int  sqlwrap() { return 1; } }
 
-static void runSelect(int attr, const char* table, const std::vector<SelCond>& conds)
+static void runSelect(const char* attr, const char* table, const std::vector<SelCond>& conds)
 {
   struct tms tmsbuf;
   clock_t btime, etime;
-  int     bpagecnt, epagecnt;
+  long long bpagecnt, epagecnt;
+  bool    cold = SqlEngine::getColdCache();
+
+  // empty the page cache first if asked to; this is not timed
+  if (cold) PageFile::dropCache();
 
   btime = times(&tmsbuf);
   bpagecnt = PageFile::getPageReadCount();
@@ -24,7 +28,41 @@ static void runSelect(int attr, const char* table, const std::vector<SelCond>& c
   etime = times(&tmsbuf);
   epagecnt = PageFile::getPageReadCount();
 
-  fprintf(stderr, "  -- %.3f seconds to run the select command. Read %d pages\n", ((float)(etime - btime))/sysconf(_SC_CLK_TCK), epagecnt - bpagecnt);
+  fprintf(stderr, "  -- %.3f seconds to run the select command. Read %lld pages%s\n", ((float)(etime - btime))/sysconf(_SC_CLK_TCK), epagecnt - bpagecnt, cold ? " (cold cache)" : "");
+}
+
+// the options of a LOAD command
+static const int LOAD_INDEX   = 0x1; // WITH INDEX
+static const int LOAD_COLUMNS = 0x2; // WITH COLUMNS
+
+static void runLoad(const char* table, const char* loadfile, int options)
+{
+  struct tms tmsbuf;
+  clock_t btime, etime;
+  long long bpagecnt, epagecnt;
+
+  btime = times(&tmsbuf);
+  bpagecnt = PageFile::getPageWriteCount();
+  SqlEngine::load(table, loadfile, (options & LOAD_INDEX) != 0, (options & LOAD_COLUMNS) != 0);
+  etime = times(&tmsbuf);
+  epagecnt = PageFile::getPageWriteCount();
+
+  fprintf(stderr, "  -- %.3f seconds to run the load command. Wrote %lld pages\n", ((float)(etime - btime))/sysconf(_SC_CLK_TCK), epagecnt - bpagecnt);
+}
+
+static void runPrewarm(const char* table)
+{
+  struct tms tmsbuf;
+  clock_t btime, etime;
+  long long bpagecnt, epagecnt;
+
+  btime = times(&tmsbuf);
+  bpagecnt = PageFile::getPageReadCount();
+  SqlEngine::prewarm(table);
+  etime = times(&tmsbuf);
+  epagecnt = PageFile::getPageReadCount();
+
+  fprintf(stderr, "  -- %.3f seconds to run the prewarm command. Read %lld pages\n", ((float)(etime - btime))/sysconf(_SC_CLK_TCK), epagecnt - bpagecnt);
 }
 
 %}
@@ -34,17 +72,21 @@ static void runSelect(int attr, const char* table, const std::vector<SelCond>& c
   char* string;
   SelCond* cond;
   std::vector<SelCond>* conds;
+  ColumnDef* column;
+  std::vector<ColumnDef>* columns;
 }
 
-%token SELECT FROM WHERE LOAD WITH INDEX QUIT COUNT AND OR 
-%token COMMA STAR LF
-%token <string> INTEGER STRING ID
+%token SELECT FROM WHERE LOAD WITH INDEX QUIT COUNT AND OR SHOW STATS PREWARM SAVE CACHE COLUMNS CREATE TABLE
+%token COMMA STAR LPAREN RPAREN LF
+%token <string> INTEGER REAL STRING ID
 %token EQUAL NEQUAL LESS LESSEQUAL GREATER GREATEREQUAL 
 
-%type <integer> attributes attribute comparator
-%type <string> table value
+%type <integer> comparator load_options load_option_list load_option
+%type <string> attributes attribute table value name
 %type <cond> condition
 %type <conds> conditions
+%type <column> column_def
+%type <columns> column_defs
 %%
 
 commands:
@@ -55,6 +97,10 @@ commands:
 command:
         load_command { fprintf(stdout, "Bruinbase> "); }
 	| select_command { fprintf(stdout, "Bruinbase> "); }
+	| show_command { fprintf(stdout, "Bruinbase> "); }
+	| prewarm_command { fprintf(stdout, "Bruinbase> "); }
+	| save_command { fprintf(stdout, "Bruinbase> "); }
+	| create_command { fprintf(stdout, "Bruinbase> "); }
 	| quit_command
 	| error LF { fprintf(stdout, "Bruinbase> "); }
 	| LF { fprintf(stdout, "Bruinbase> "); }
@@ -65,15 +111,88 @@ quit_command:
 	;
 
 load_command:
-	LOAD table FROM STRING LF { 
-	  SqlEngine::load(std::string($2), std::string($4), false); 
+	LOAD table FROM STRING load_options LF { 
+	  runLoad($2, $4, $5); 
 	  free($2);
 	  free($4);
 	}
-	| LOAD table FROM STRING WITH INDEX LF { 
-	  SqlEngine::load(std::string($2), std::string($4), true); 
+	;
+
+load_options:
+	WITH load_option_list { $$ = $2; }
+	| { $$ = 0; }
+	;
+
+load_option_list:
+	load_option_list COMMA load_option { $$ = $1 | $3; }
+	| load_option { $$ = $1; }
+	;
+
+load_option:
+	INDEX { $$ = LOAD_INDEX; }
+	| COLUMNS { $$ = LOAD_COLUMNS; }
+	;
+
+show_command:
+	SHOW STATS LF {
+	  SqlEngine::showStats();
+	}
+	;
+
+prewarm_command:
+	PREWARM table LF {
+	  runPrewarm($2);
 	  free($2);
+	}
+	;
+
+save_command:
+	SAVE CACHE LF {
+	  SqlEngine::saveCache();
+	}
+	;
+
+create_command:
+	CREATE TABLE table LPAREN column_defs RPAREN LF {
+	  SqlEngine::create($3, *$5);
+	  free($3);
+	  for (unsigned i = 0; i < $5->size(); i++) {
+	    free((*$5)[i].name);
+	    free((*$5)[i].type);
+	  }
+	  delete $5;
+	}
+	;
+
+column_defs:
+	column_def {
+	  std::vector<ColumnDef>* v = new std::vector<ColumnDef>;
+	  v->push_back(*$1);
+	  $$ = v;
+	  delete $1;
+	}
+	| column_defs COMMA column_def {
+	  $1->push_back(*$3);
+	  $$ = $1;
+	  delete $3;
+	}
+	;
+
+column_def:
+	name ID {
+	  ColumnDef* c = new ColumnDef;
+	  c->name = $1;
+	  c->type = $2;
+	  c->length = 0;
+	  $$ = c;
+	}
+	| name ID LPAREN INTEGER RPAREN {
+	  ColumnDef* c = new ColumnDef;
+	  c->name = $1;
+	  c->type = $2;
+	  c->length = atoi($4);
 	  free($4);
+	  $$ = c;
 	}
 	;
 
@@ -81,12 +200,15 @@ select_command:
 	SELECT attributes FROM table LF {
    	        std::vector<SelCond> conds;
 		runSelect($2, $4, conds);
+		free($2);
 		free($4);
 	}
 	| SELECT attributes FROM table WHERE conditions LF {
 	        runSelect($2, $4, *$6);
+	  	free($2);
 	  	free($4);
 	  	for (unsigned i = 0; i < $6->size(); i++) {
+		    free((*$6)[i].name);
 		    free((*$6)[i].value);
 		}
 	  	delete $6;
@@ -110,7 +232,8 @@ conditions:
 condition:
 	attribute comparator value { 
 	  SelCond* c = new SelCond;
-	  c->attr = $1;
+	  c->attr = 0;
+	  c->name = $1;
 	  c->comp = static_cast<SelCond::Comparator>($2);
 	  c->value = $3;
 	  $$ = c;
@@ -119,25 +242,37 @@ condition:
 
 attributes:
 	attribute { $$ = $1; }
-	| STAR  { $$ = 3; }
-	| COUNT { $$ = 4; }
+	| STAR  { $$ = strdup("*"); }
+	| COUNT { $$ = strdup("count(*)"); }
 	;
 
 attribute:
-	ID { 
-		if (strcasecmp($1, "key") == 0) $$=1;
-		else if (strcasecmp($1, "value") == 0) $$=2;
-		else sqlerror("wrong attribute name. neither key or value");
-		free($1);
-	}
+	name { $$ = $1; }
+	;
 
 value:
 	INTEGER  { $$ = $1; }
+	| REAL   { $$ = $1; }
         | STRING { $$ = $1; }
 	;
 
 table:
-	ID { $$ = $1; }
+	name { $$ = $1; }
+	;
+
+/* the keywords of the commands added to SELECT, LOAD and QUIT are only
+   keywords where those commands expect them; elsewhere they still name
+   tables and columns, as they did before the commands existed */
+name:
+	ID        { $$ = $1; }
+	| SHOW    { $$ = strdup("show"); }
+	| STATS   { $$ = strdup("stats"); }
+	| PREWARM { $$ = strdup("prewarm"); }
+	| SAVE    { $$ = strdup("save"); }
+	| CACHE   { $$ = strdup("cache"); }
+	| COLUMNS { $$ = strdup("columns"); }
+	| CREATE  { $$ = strdup("create"); }
+	| TABLE   { $$ = strdup("table"); }
 	;
 
 comparator:
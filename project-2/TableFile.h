@@ -0,0 +1,242 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/17/2026
+ */
+
+#ifndef TABLEFILE_H
+#define TABLEFILE_H
+
+#include <string>
+#include <vector>
+#include "Bruinbase.h"
+#include "PageFile.h"
+
+/**
+ * The data structure for pointing to a particular record in a RecordFile.
+ * A record id consists of pid (PageId) and sid (the slot number in the page)
+ */
+typedef struct {
+  PageId  pid;  // page number. the first page is 0
+  int     sid;  // slot number. the first slot is 0
+} RecordId;
+
+//
+// helper functions for RecordId (see RecordFile.cc)
+// 
+
+// RecordId iterators
+RecordId& operator++ (RecordId& rid);
+RecordId  operator++ (RecordId& rid, int);
+
+// RecordId comparators
+bool operator> (const RecordId& r1, const RecordId& r2);
+bool operator< (const RecordId& r1, const RecordId& r2);
+bool operator>= (const RecordId& r1, const RecordId& r2);
+bool operator<= (const RecordId& r1, const RecordId& r2);
+bool operator== (const RecordId& r1, const RecordId& r2);
+bool operator!= (const RecordId& r1, const RecordId& r2);
+
+/**
+ * a value read in place: length bytes starting at data, not terminated by
+ * a NUL. the bytes belong to the ScanBatch the value was read into.
+ */
+struct ValueView {
+  const char* data;
+  int         length;
+};
+
+/**
+ * the records of one page of a table, read together by TableFile::nextBatch()
+ * (the keys) and TableFile::readValues() (the values). the values are read
+ * in place while the batch keeps their page pinned in the page cache, and
+ * stay valid until the batch is reused or destroyed.
+ */
+class ScanBatch {
+ public:
+  PageId pid;   // the page of the records
+  int    first; // the sid of the first record
+  int    count; // # of records
+
+  std::vector<int>       keys;   // the key of each record
+  std::vector<ValueView> values; // the value of each record, once read
+
+  // for a table stored by columns (see ColumnFile): the code of each
+  // value, and the dictionary of the block they index. empty otherwise
+  std::vector<int>         codes;
+  std::vector<std::string> dict;
+
+  PinnedPage               page;     // the page the values are read from
+  std::string              copy;     // or its copy, once the page is released
+  std::vector<std::string> overflow; // values too long to be stored in the page
+
+  /**
+   * forget the records of the batch and release its page.
+   */
+  void clear() {
+    count = 0;
+    keys.clear();
+    values.clear();
+    codes.clear();
+    dict.clear();
+    overflow.clear();
+    copy.clear();
+    page.release();
+  }
+};
+
+/**
+ * the value of one record read by TableFile::readValue() in place: a view
+ * of its bytes in the page of the record, which the ValueRef keeps pinned
+ * in the page cache, or in a copy the ValueRef holds if the value is not
+ * stored whole in a page. the memory of a ValueRef is reused by the next
+ * value read into it, so that reading one value after another does not
+ * allocate.
+ */
+class ValueRef {
+ public:
+  ValueView value; // the value, once read
+
+  PinnedPage  page;       // the page the value is read from
+  std::string copy;       // or its copy
+  std::string scratch[2]; // room for the table file to read the value in
+
+  /**
+   * forget the value and release its page.
+   */
+  void clear() {
+    value.data = NULL;
+    value.length = 0;
+    copy.clear();
+    page.release();
+  }
+};
+
+/**
+ * The (key, value) records of a table, whichever way they are stored:
+ * by rows (RecordFile) or by columns (ColumnFile). SqlEngine reads and
+ * loads tables through this interface.
+ */
+class TableFile {
+ public:
+  virtual ~TableFile() {}
+
+  /**
+   * close the table.
+   * @return error code. 0 if no error
+   */
+  virtual RC close() = 0;
+
+  /**
+   * read a record from the table.
+   * @param rid[IN] the id of the record to read
+   * @param key[OUT] the record key
+   * @param value[OUT] the record value
+   * @return error code. 0 if no error
+   */
+  virtual RC read(const RecordId& rid, int& key, std::string& value) const = 0;
+
+  /**
+   * read only the key of a record.
+   * @param rid[IN] the id of the record to read
+   * @param key[OUT] the record key
+   * @return error code. 0 if no error
+   */
+  virtual RC readKey(const RecordId& rid, int& key) const = 0;
+
+  /**
+   * read only the value of a record.
+   * @param rid[IN] the id of the record to read
+   * @param value[OUT] the record value
+   * @return error code. 0 if no error
+   */
+  virtual RC readValue(const RecordId& rid, std::string& value) const = 0;
+
+  /**
+   * read only the value of a record, in place where it can be.
+   * @param rid[IN] the id of the record to read
+   * @param ref[OUT] the record value, valid until ref is cleared or reused
+   * @return error code. 0 if no error
+   */
+  virtual RC readValue(const RecordId& rid, ValueRef& ref) const = 0;
+
+  /**
+   * append a new record at the end of the table.
+   * @param key[IN] the record key
+   * @param value[IN] the record value
+   * @param rid[OUT] the location of the stored record
+   * @return error code. 0 if no error
+   */
+  virtual RC append(int key, const std::string& value, RecordId& rid) = 0;
+
+  /**
+   * append a batch of records at the end of the table, writing each
+   * page once.
+   * @param keys[IN] the record keys
+   * @param values[IN] the record values, one for each key
+   * @param rids[OUT] the location of each stored record
+   * @return error code. 0 if no error
+   */
+  virtual RC appendBatch(const std::vector<int>& keys, const std::vector<std::string>& values, std::vector<RecordId>& rids) = 0;
+
+  /**
+   * @return (last record id + 1) of the table
+   */
+  virtual const RecordId& endRid() const = 0;
+
+  /**
+   * move a record id forward to the first record at or after it.
+   * @param rid[IN/OUT] the record id to move, e.g., (0, 0) to find the first record
+   * @return error code. RC_NO_SUCH_RECORD if no record is left
+   */
+  virtual RC seek(RecordId& rid) const = 0;
+
+  /**
+   * move a record id to the next record of the table.
+   * @param rid[IN/OUT] the id of a record
+   * @return error code. RC_NO_SUCH_RECORD if it was the last record
+   */
+  virtual RC next(RecordId& rid) const = 0;
+
+  /**
+   * read the keys of the records of a page in one go, starting at the
+   * first record at or after a record id. a scan of the table calls this
+   * function until it returns RC_NO_SUCH_RECORD.
+   * @param rid[IN/OUT] where the scan is; moved to the first record of the next page
+   * @param batch[OUT] the records read
+   * @return error code. RC_NO_SUCH_RECORD if no record is left
+   */
+  virtual RC nextBatch(RecordId& rid, ScanBatch& batch) const = 0;
+
+  /**
+   * read the values of the records of a batch read by nextBatch().
+   * @param batch[IN/OUT] the batch
+   * @return error code. 0 if no error
+   */
+  virtual RC readValues(ScanBatch& batch) const = 0;
+
+  /**
+   * read the pages holding a set of records into the page cache.
+   * @param rids[IN] the records that are going to be read
+   * @return error code. 0 if no error
+   */
+  virtual RC prefetch(const std::vector<RecordId>& rids) const = 0;
+
+  /**
+   * read the first pages of the table into the page cache, in order.
+   * @param maxPages[IN] the most pages to read
+   * @param count[OUT] the # of pages read
+   * @return error code. 0 if no error
+   */
+  virtual RC prewarm(int maxPages, int& count) const = 0;
+
+  /**
+   * tell the kernel in which order the records are going to be read.
+   * @param pattern[IN] the expected access pattern
+   * @return error code. 0 if no error
+   */
+  virtual RC setAccessPattern(PageFile::AccessPattern pattern) = 0;
+};
+
+#endif // TABLEFILE_H
@@ -0,0 +1,342 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/17/2026
+ */
+
+#include "WriteAheadLog.h"
+#include "PageFile.h"
+#include <map>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+using std::string;
+
+const char* const WriteAheadLog::LOG_FILE = "bruinbase.wal";
+
+std::atomic<int> WriteAheadLog::fd(-1);
+long long WriteAheadLog::generation = 0;
+long long WriteAheadLog::logEnd = 0;
+std::vector<char> WriteAheadLog::buffer;
+std::vector<string> WriteAheadLog::names;
+std::unordered_map<string, int> WriteAheadLog::nameIds;
+std::unordered_map<PageKey, size_t, PageKeyHash> WriteAheadLog::pending;
+long long WriteAheadLog::appended = 0;
+long long WriteAheadLog::synced = 0;
+std::mutex WriteAheadLog::latch;
+std::mutex WriteAheadLog::ioLatch;
+std::atomic<long long> WriteAheadLog::recordCount(0);
+std::atomic<long long> WriteAheadLog::absorbedCount(0);
+std::atomic<long long> WriteAheadLog::commitCount(0);
+std::atomic<long long> WriteAheadLog::syncCount(0);
+std::atomic<long long> WriteAheadLog::checkpointCount(0);
+std::atomic<long long> WriteAheadLog::recoveredCount(0);
+
+RC WriteAheadLog::open()
+{
+  RC  rc;
+  int lfd;
+
+  if (fd >= 0) return RC_FILE_OPEN_FAILED;
+
+  // pages left in the log by a crash go to their files first
+  if ((rc = recover()) < 0) return rc;
+
+  if ((lfd = ::open(LOG_FILE, O_RDWR|O_CREAT|O_TRUNC, 0644)) < 0) return RC_FILE_OPEN_FAILED;
+  fd = lfd;
+
+  std::lock_guard<std::mutex> io(ioLatch);
+  if ((rc = reset(1)) < 0) {
+    ::close(lfd);
+    fd = -1;
+  }
+  return rc;
+}
+
+RC WriteAheadLog::close()
+{
+  RC rc;
+
+  if (fd < 0) return 0;
+
+  // the records are not needed once their pages are on disk
+  if ((rc = checkpoint()) < 0) return rc;
+
+  std::lock_guard<std::mutex> io(ioLatch);
+  std::lock_guard<std::mutex> guard(latch);
+  ::close(fd);
+  fd = -1;
+  ::unlink(LOG_FILE);
+
+  buffer.clear();
+  pending.clear();
+  names.clear();
+  nameIds.clear();
+  appended = synced = 0;
+
+  return 0;
+}
+
+RC WriteAheadLog::append(const string& file, PageId pid, const char* page)
+{
+  RecordHeader header;
+  bool full;
+
+  {
+    std::lock_guard<std::mutex> guard(latch);
+    if (fd < 0) return 0;
+
+    std::unordered_map<string, int>::iterator name = nameIds.find(file);
+    if (name == nameIds.end()) {
+      name = nameIds.insert(std::make_pair(file, (int)names.size())).first;
+      names.push_back(file);
+    }
+
+    // a page logged again before its record left memory only updates it
+    PageKey key = { name->second, pid };
+    std::unordered_map<PageKey, size_t, PageKeyHash>::iterator rec = pending.find(key);
+    if (rec != pending.end()) {
+      memcpy(&buffer[rec->second + sizeof(header) + file.size()], page, PageFile::PAGE_SIZE);
+      absorbedCount++;
+    } else {
+      // the checksum and generation are filled in when the record is written out
+      header.checksum = 0;
+      header.nameLength = (int)file.size();
+      header.generation = 0;
+      header.pid = pid;
+
+      size_t offset = buffer.size();
+      buffer.resize(offset + sizeof(header) + file.size() + PageFile::PAGE_SIZE);
+      memcpy(&buffer[offset], &header, sizeof(header));
+      memcpy(&buffer[offset + sizeof(header)], file.data(), file.size());
+      memcpy(&buffer[offset + sizeof(header) + file.size()], page, PageFile::PAGE_SIZE);
+      pending[key] = offset;
+      recordCount++;
+    }
+
+    appended++;
+    full = (buffer.size() >= BUFFER_SIZE);
+  }
+
+  if (!full) return 0;
+
+  std::lock_guard<std::mutex> io(ioLatch);
+  return writeOut(false);
+}
+
+RC WriteAheadLog::commit()
+{
+  long long target;
+  long long size;
+  RC rc;
+
+  if (fd < 0) return 0;
+  commitCount++;
+
+  {
+    std::lock_guard<std::mutex> guard(latch);
+    target = appended;
+    if (synced >= target) return 0;
+  }
+
+  {
+    // while another thread syncs, the records of this one pile up, and
+    // the first thread to get here next syncs them all in one go
+    std::lock_guard<std::mutex> io(ioLatch);
+    {
+      std::lock_guard<std::mutex> guard(latch);
+      if (synced >= target) return 0;
+    }
+    // compressed pages that moved are only found through their page map
+    if ((rc = PageFile::savePageMaps()) < 0) return rc;
+    if ((rc = writeOut(true)) < 0) return rc;
+    size = logEnd;
+  }
+
+  // keep the log, and the time to recover it, bounded
+  return (size > CHECKPOINT_SIZE) ? checkpoint() : 0;
+}
+
+RC WriteAheadLog::checkpoint()
+{
+  std::vector<string> files;
+  RC rc;
+
+  if (fd < 0) return 0;
+
+  // no record goes to the log file until it is emptied
+  std::lock_guard<std::mutex> io(ioLatch);
+
+  // pages are logged after they are written, so every page of a record
+  // appended so far is in its file or in the page cache by now
+  if ((rc = PageFile::flushOpenFiles()) < 0) return rc;
+  {
+    std::lock_guard<std::mutex> guard(latch);
+    files = names;
+  }
+  for (unsigned i = 0; i < files.size(); i++) {
+    if ((rc = syncFile(files[i])) < 0) return rc;
+  }
+
+  // records still in memory describe later writes and stay
+  if ((rc = reset(generation + 1)) < 0) return rc;
+  checkpointCount++;
+
+  return 0;
+}
+
+RC WriteAheadLog::recover()
+{
+  static std::recursive_mutex once;
+  static bool done = false;
+  std::map<string, PageFile*> files;
+  std::vector<char> record;
+  FileHeader   fileHeader;
+  RecordHeader header;
+  RC  rc = 0;
+  int lfd;
+
+  // opening the files to recover calls this function again
+  std::lock_guard<std::recursive_mutex> guard(once);
+  if (done) return 0;
+  done = true;
+
+  if ((lfd = ::open(LOG_FILE, O_RDONLY)) < 0) return 0;
+  if (::pread(lfd, &fileHeader, sizeof(fileHeader), 0) != sizeof(fileHeader)) {
+    ::close(lfd);
+    ::unlink(LOG_FILE);
+    return 0;
+  }
+  if (fileHeader.magic != LOG_MAGIC || fileHeader.pageSize != PageFile::PAGE_SIZE) {
+    ::close(lfd);
+    return RC_INVALID_FILE_FORMAT;
+  }
+
+  // redo the records in order, up to the first one that is incomplete
+  // or left over from before the log was last emptied
+  for (off_t offset = sizeof(fileHeader); ; ) {
+    if (::pread(lfd, &header, sizeof(header), offset) != sizeof(header)) break;
+    if (header.nameLength <= 0 || header.nameLength > 4096 ||
+        header.generation != fileHeader.generation) break;
+
+    ssize_t length = sizeof(header) + header.nameLength + PageFile::PAGE_SIZE;
+    record.resize(length);
+    if (::pread(lfd, &record[0], length, offset) != length) break;
+    if (checksum(&record[sizeof(header.checksum)], length - sizeof(header.checksum),
+                 (unsigned)header.generation) != header.checksum) break;
+    offset += length;
+
+    string name(&record[sizeof(header)], header.nameLength);
+    PageFile*& pf = files[name];
+    if (pf == NULL) {
+      pf = new PageFile;
+      if ((rc = pf->open(name, 'w', 0)) < 0) break;
+    }
+    if ((rc = pf->write(header.pid, &record[sizeof(header) + header.nameLength])) < 0) break;
+    recoveredCount++;
+  }
+  ::close(lfd);
+
+  // the log may only go once the recovered pages are on disk
+  for (std::map<string, PageFile*>::iterator it = files.begin(); it != files.end(); ++it) {
+    RC rc2 = it->second->close();
+    if (rc2 == 0) rc2 = syncFile(it->first);
+    if (rc == 0) rc = rc2;
+    delete it->second;
+  }
+  if (rc < 0) return rc;
+  ::unlink(LOG_FILE);
+
+  return 0;
+}
+
+RC WriteAheadLog::writeOut(bool sync)
+{
+  std::vector<char> out;
+  long long upto;
+
+  // take the records out of memory; appends go on meanwhile
+  {
+    std::lock_guard<std::mutex> guard(latch);
+    out.swap(buffer);
+    buffer.reserve(out.size());
+    pending.clear();
+    upto = appended;
+  }
+
+  // seal the records for the current generation of the log
+  for (size_t offset = 0; offset < out.size(); ) {
+    RecordHeader header;
+    memcpy(&header, &out[offset], sizeof(header));
+    size_t length = sizeof(header) + header.nameLength + PageFile::PAGE_SIZE;
+
+    header.generation = generation;
+    memcpy(&out[offset], &header, sizeof(header));
+    header.checksum = checksum(&out[offset + sizeof(header.checksum)],
+                               length - sizeof(header.checksum), (unsigned)generation);
+    memcpy(&out[offset], &header.checksum, sizeof(header.checksum));
+    offset += length;
+  }
+
+  if (!out.empty()) {
+    if (::pwrite(fd, &out[0], out.size(), logEnd) != (ssize_t)out.size()) return RC_FILE_WRITE_FAILED;
+    logEnd += out.size();
+  }
+
+  if (sync) {
+    if (::fdatasync(fd) < 0) return RC_FILE_WRITE_FAILED;
+    syncCount++;
+
+    std::lock_guard<std::mutex> guard(latch);
+    if (upto > synced) synced = upto;
+  }
+
+  return 0;
+}
+
+RC WriteAheadLog::reset(long long generation)
+{
+  FileHeader header = { LOG_MAGIC, PageFile::PAGE_SIZE, generation };
+
+  // records of an older generation are ignored by recover(), even if
+  // they are still in the file after a crash
+  if (::ftruncate(fd, sizeof(header)) < 0 ||
+      ::pwrite(fd, &header, sizeof(header), 0) != sizeof(header) ||
+      ::fdatasync(fd) < 0) {
+    return RC_FILE_WRITE_FAILED;
+  }
+
+  WriteAheadLog::generation = generation;
+  logEnd = sizeof(header);
+  return 0;
+}
+
+unsigned WriteAheadLog::checksum(const char* data, size_t length, unsigned seed)
+{
+  // 32-bit FNV-1a
+  unsigned hash = 2166136261u ^ seed;
+  for (size_t i = 0; i < length; i++) {
+    hash = (hash ^ (unsigned char)data[i]) * 16777619u;
+  }
+  return hash;
+}
+
+RC WriteAheadLog::syncFile(const string& name)
+{
+  const string files[2] = { name, name + ".map" };
+
+  // a compressed file is only complete with its page map
+  for (int i = 0; i < 2; i++) {
+    int sfd = ::open(files[i].c_str(), O_RDONLY);
+    if (sfd < 0) continue; // e.g., removed since it was written
+    int rc = ::fsync(sfd);
+    ::close(sfd);
+    if (rc < 0) return RC_FILE_WRITE_FAILED;
+  }
+
+  // a file created since the last checkpoint, by recover() among others,
+  // has to stay in its directory
+  return PageFile::syncDirectory(name);
+}
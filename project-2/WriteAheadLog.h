@@ -0,0 +1,151 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/17/2026
+ */
+
+#ifndef WRITEAHEADLOG_H
+#define WRITEAHEADLOG_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+#include "Bruinbase.h"
+#include "BufferPool.h"
+
+/**
+ * A redo log of the pages written by every PageFile, so that written data
+ * survives a crash without every page write being synced to disk.
+ *
+ * PageFile::write() appends the new image of a page to the log once the
+ * page is written to its file or to the page cache. Records are kept in
+ * memory and written to the log file in large batches; a page written
+ * again before its record left memory only updates the record.
+ * commit() makes every record appended so far durable with one fdatasync.
+ * Threads that commit while another thread is syncing wait for it and are
+ * then usually covered by the next sync, so that concurrent commits share
+ * their syncs (group commit).
+ *
+ * A checkpoint writes every dirty page of the page cache to its file, syncs
+ * the files logged since the last checkpoint and empties the log. It runs
+ * when the log grows beyond CHECKPOINT_SIZE at a commit, and on close().
+ *
+ * recover() writes the pages of the records left in the log by a crash back
+ * to their files. PageFile::open() calls it before the first file is opened,
+ * whether or not logging is turned on in this run.
+ * Pages are logged whole and logging is redo-only: a crash in the middle
+ * of a LOAD may leave part of its rows, but every row of a committed LOAD
+ * is kept. A page is assumed to reach the disk in one piece.
+ */
+class WriteAheadLog {
+ public:
+  static const size_t BUFFER_SIZE = (size_t)32 << 20;  // records kept in memory
+  static const long long CHECKPOINT_SIZE = 64LL << 20; // log size that triggers a checkpoint
+
+  /**
+   * start logging the pages written by every PageFile to LOG_FILE,
+   * after recovering the records left in it.
+   * @return error code. 0 if no error
+   */
+  static RC open();
+
+  /**
+   * take a checkpoint and stop logging. the log file is removed.
+   * @return error code. 0 if no error
+   */
+  static RC close();
+
+  /**
+   * @return whether page writes are logged
+   */
+  static bool isOpen() { return fd.load() >= 0; }
+
+  /**
+   * log the new content of a page. the record is not durable until commit().
+   * @param file[IN] the name the file of the page was opened with
+   * @param pid[IN] the page written
+   * @param page[IN] the new page content
+   * @return error code. 0 if no error
+   */
+  static RC append(const std::string& file, PageId pid, const char* page);
+
+  /**
+   * make every record appended so far durable. the page maps of the
+   * compressed files are saved first (see PageFile::savePageMaps()).
+   * @return error code. 0 if no error
+   */
+  static RC commit();
+
+  /**
+   * write every logged page to its file, sync the files and empty the log.
+   * @return error code. 0 if no error
+   */
+  static RC checkpoint();
+
+  /**
+   * redo the records left in the log by a crash, once per run.
+   * the log is kept if a file of the records cannot be opened, e.g.,
+   * because its header page was lost.
+   * @return error code. 0 if no error
+   */
+  static RC recover();
+
+  static long long getRecordCount()   { return recordCount; }
+  static long long getAbsorbedCount() { return absorbedCount; }
+  static long long getCommitCount()   { return commitCount; }
+  static long long getSyncCount()     { return syncCount; }
+  static long long getCheckpointCount() { return checkpointCount; }
+  static long long getRecoveredCount() { return recoveredCount; }
+
+  // the log file, in the current directory
+  static const char* const LOG_FILE;
+
+ private:
+  // the start of the log file
+  struct FileHeader {
+    int magic;      // LOG_MAGIC
+    int pageSize;   // PageFile::PAGE_SIZE
+    long long generation; // bumped whenever the log is emptied
+  };
+
+  // the start of a record, followed by the file name and the page
+  struct RecordHeader {
+    unsigned  checksum;   // of the rest of the record
+    int       nameLength; // # of bytes of the file name
+    long long generation; // the generation of the log when written
+    PageId    pid;        // the page
+  };
+
+  static RC   writeOut(bool sync);
+  static RC   reset(long long generation);
+  static unsigned checksum(const char* data, size_t length, unsigned seed);
+  static RC   syncFile(const std::string& name);
+
+  static const int LOG_MAGIC = 0x4c415742; // "BWAL"
+
+  static std::atomic<int> fd;  // the log file, or -1 if not logging
+  static long long   generation; // the generation of the records written
+  static long long   logEnd;   // the end of the records in the log file
+
+  static std::vector<char> buffer;     // records not written to the log file yet
+  static std::vector<std::string> names; // the files logged so far
+  static std::unordered_map<std::string, int> nameIds; // file name -> index in names
+  static std::unordered_map<PageKey, size_t, PageKeyHash> pending; // page -> its record in buffer
+  static long long   appended;  // # of records appended so far
+  static long long   synced;    // # of records known to be durable
+  static std::mutex  latch;     // protects the members above, but generation and logEnd
+  static std::mutex  ioLatch;   // serializes writing to the log file,
+                                // protects generation and logEnd
+
+  static std::atomic<long long> recordCount;     // records written to the log
+  static std::atomic<long long> absorbedCount;   // records updated in memory instead
+  static std::atomic<long long> commitCount;     // calls to commit()
+  static std::atomic<long long> syncCount;       // fdatasync calls on the log
+  static std::atomic<long long> checkpointCount; // checkpoints taken
+  static std::atomic<long long> recoveredCount;  // pages redone by recover()
+};
+
+#endif // WRITEAHEADLOG_H
@@ -0,0 +1,238 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/17/2026
+ */
+
+#include <cstring>
+#include "ZoneMap.h"
+
+using namespace std;
+
+/*
+ * the bits of a value in the Bloom filter are h1, h1 + h2, h1 + 2*h2, ...
+ * for the two halves of its 64 bit FNV-1a hash
+ */
+static void hashValue(const char* data, int length, unsigned& h1, unsigned& h2)
+{
+  unsigned long long h = 14695981039346656037ULL;
+
+  for (int i = 0; i < length; i++) {
+    h ^= (unsigned char)data[i];
+    h *= 1099511628211ULL;
+  }
+  h1 = (unsigned)h;
+  h2 = (unsigned)(h >> 32) | 1;
+}
+
+// compare two values the way strcmp() does
+static int compareValues(const char* a, int alength, const char* b, int blength)
+{
+  int diff = memcmp(a, b, (alength < blength) ? alength : blength);
+
+  return (diff != 0) ? diff : alength - blength;
+}
+
+void ZoneMap::Zone::add(int key, const ValueView& value)
+{
+  const int length = (value.length < PREFIX_LENGTH) ? value.length : PREFIX_LENGTH;
+  unsigned  h1, h2;
+
+  if (count == 0) {
+    minKey = maxKey = key;
+    memcpy(low, value.data, length);
+    memcpy(high, value.data, length);
+    lowLength = highLength = (unsigned char)length;
+    highTruncated = (value.length > PREFIX_LENGTH);
+  } else {
+    if (key < minKey) minKey = key;
+    if (key > maxKey) maxKey = key;
+
+    // the prefix of a smaller value is a lower bound of it too
+    if (compareValues(value.data, value.length, low, lowLength) < 0) {
+      memcpy(low, value.data, length);
+      lowLength = (unsigned char)length;
+    }
+
+    // a value sharing the prefix of a truncated high leaves it as it is
+    if (!highTruncated ? compareValues(value.data, value.length, high, highLength) > 0
+                       : compareValues(value.data, length, high, highLength) > 0) {
+      memcpy(high, value.data, length);
+      highLength = (unsigned char)length;
+      highTruncated = (value.length > PREFIX_LENGTH);
+    }
+  }
+  count++;
+
+  hashValue(value.data, value.length, h1, h2);
+  for (int i = 0; i < BLOOM_HASHES; i++) {
+    unsigned bit = (h1 + i * h2) % (BLOOM_BYTES * 8);
+    bloom[bit / 8] |= (unsigned char)(1 << (bit % 8));
+  }
+}
+
+bool ZoneMap::Zone::mayContain(const string& value) const
+{
+  unsigned h1, h2;
+
+  hashValue(value.data(), (int)value.size(), h1, h2);
+  for (int i = 0; i < BLOOM_HASHES; i++) {
+    unsigned bit = (h1 + i * h2) % (BLOOM_BYTES * 8);
+    if (!(bloom[bit / 8] & (1 << (bit % 8)))) return false;
+  }
+  return true;
+}
+
+bool ZoneMap::Zone::mayBeLess(const string& value, bool orEqual) const
+{
+  int diff = compareValues(low, lowLength, value.data(), (int)value.size());
+
+  return orEqual ? diff <= 0 : diff < 0;
+}
+
+bool ZoneMap::Zone::mayBeGreater(const string& value, bool orEqual) const
+{
+  int diff;
+
+  // every value of the page starts with at most high; one starting
+  // with high itself may be larger than any value with that prefix
+  if (highTruncated) {
+    diff = compareValues(value.data(), ((int)value.size() < highLength) ? (int)value.size() : highLength, high, highLength);
+    return diff <= 0;
+  }
+
+  diff = compareValues(high, highLength, value.data(), (int)value.size());
+  return orEqual ? diff >= 0 : diff > 0;
+}
+
+ZoneMap::ZoneMap()
+{
+  end.pid = end.sid = 0;
+}
+
+RC ZoneMap::open(const string& filename, char mode)
+{
+  RC     rc;
+  Header header;
+  char   page[PageFile::PAGE_SIZE];
+
+  changed.clear();
+  end.pid = end.sid = 0;
+  if ((rc = pf.open(filename, mode)) < 0) return rc;
+
+  // a scan reads a zone page for many table pages, and may stop reading
+  // them early (see SqlEngine::scanTable()); reading ahead does not pay
+  pf.setAccessPattern(PageFile::RANDOM);
+
+  // a new file summarizes an empty table
+  if (pf.endPid() == 0) return 0;
+
+  if ((rc = pf.read(0, page)) < 0) {
+    pf.close();
+    return rc;
+  }
+  memcpy(&header, page, sizeof(header));
+  if (header.magic != MAGIC || header.version != VERSION) {
+    pf.close();
+    return RC_INVALID_FILE_FORMAT;
+  }
+  end = header.end;
+  return 0;
+}
+
+RC ZoneMap::close(const RecordId& end)
+{
+  RC     rc;
+  Header header;
+  char   page[PageFile::PAGE_SIZE];
+  PageId pid = -1;
+
+  // write out every zone page with a zone built, a page at a time
+  for (map<PageId, Zone>::const_iterator it = changed.begin(); it != changed.end(); ++it) {
+    if (pid != 1 + it->first / ZONES_PER_PAGE) {
+      if (pid >= 0 && (rc = pf.write(pid, page)) < 0) goto close_failed;
+      pid = 1 + it->first / ZONES_PER_PAGE;
+      if (pid < pf.endPid()) {
+        if ((rc = pf.read(pid, page)) < 0) goto close_failed;
+      } else {
+        memset(page, 0, PageFile::PAGE_SIZE);
+      }
+    }
+    memcpy(page + (it->first % ZONES_PER_PAGE) * sizeof(Zone), &it->second, sizeof(Zone));
+  }
+  if (pid >= 0 && (rc = pf.write(pid, page)) < 0) goto close_failed;
+
+  // the zones are valid for the table once the header says so
+  memset(page, 0, PageFile::PAGE_SIZE);
+  header.magic = MAGIC;
+  header.version = VERSION;
+  header.end = end;
+  memcpy(page, &header, sizeof(header));
+  if ((rc = pf.write(0, page)) < 0) goto close_failed;
+
+  changed.clear();
+  return pf.close();
+
+  close_failed:
+  close();
+  return rc;
+}
+
+RC ZoneMap::close()
+{
+  changed.clear();
+  return pf.close();
+}
+
+bool ZoneMap::covers(const RecordId& end) const
+{
+  return this->end == end;
+}
+
+RC ZoneMap::summarize(const TableFile& tf, PageId first, PageId last)
+{
+  RC        rc;
+  RecordId  rid;
+  ScanBatch batch;
+  Zone      empty;
+
+  // the pages without records (e.g., overflow pages) keep an empty zone
+  memset(&empty, 0, sizeof(empty));
+  for (PageId pid = first; pid <= last; pid++) {
+    changed[pid] = empty;
+  }
+
+  rid.pid = first;
+  rid.sid = 0;
+  while ((rc = tf.nextBatch(rid, batch)) == 0 && batch.pid <= last) {
+    if ((rc = tf.readValues(batch)) < 0) return rc;
+
+    Zone& zone = changed[batch.pid];
+    for (int i = 0; i < batch.count; i++) {
+      zone.add(batch.keys[i], batch.values[i]);
+    }
+  }
+
+  return (rc == RC_NO_SUCH_RECORD) ? 0 : rc;
+}
+
+RC ZoneMap::getZone(PageId pid, Zone& zone) const
+{
+  RC         rc;
+  PinnedPage page;
+
+  // a page at or after the end of the table has no zone
+  if (pid < 0 || pid > end.pid || (pid == end.pid && end.sid == 0)) return RC_INVALID_PID;
+
+  map<PageId, Zone>::const_iterator it = changed.find(pid);
+  if (it != changed.end()) {
+    zone = it->second;
+    return 0;
+  }
+
+  if (1 + pid / ZONES_PER_PAGE >= pf.endPid()) return RC_INVALID_PID;
+  if ((rc = page.pin(pf, 1 + pid / ZONES_PER_PAGE)) < 0) return rc;
+  memcpy(&zone, page.data() + (pid % ZONES_PER_PAGE) * sizeof(Zone), sizeof(Zone));
+  return 0;
+}
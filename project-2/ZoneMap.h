@@ -0,0 +1,149 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/17/2026
+ */
+
+#ifndef ZONEMAP_H
+#define ZONEMAP_H
+
+#include <string>
+#include <map>
+#include "Bruinbase.h"
+#include "PageFile.h"
+#include "TableFile.h"
+
+/**
+ * a summary of the records of every page of a table (a zone), so that a
+ * scan can skip the pages that cannot hold a record it is looking for.
+ *
+ * a zone holds the smallest and largest key of the page, a lower and an
+ * upper bound of its values, and a Bloom filter of its values. the zones
+ * are kept in their own page file, built by LOAD (see SqlEngine::load())
+ * from the pages it wrote. the first page of the file records the end
+ * record id of the table the zones were built for; if the table has
+ * changed since, its zones are not used.
+ */
+class ZoneMap {
+ public:
+  // # of bytes of a value kept as its lower or upper bound
+  static const int PREFIX_LENGTH = 24;
+
+  // # of bytes of the Bloom filter of a zone
+  static const int BLOOM_BYTES = PageFile::PAGE_SIZE / 16;
+
+  // # of bits of the Bloom filter set for each value
+  static const int BLOOM_HASHES = 3;
+
+  /**
+   * the summary of the records of one page
+   */
+  struct Zone {
+    int           count;         // # of records; 0 if the page holds none
+    int           minKey;        // the smallest key
+    int           maxKey;        // the largest key
+    unsigned char lowLength;     // # of bytes of low
+    unsigned char highLength;    // # of bytes of high
+    unsigned char highTruncated; // whether high is only a prefix of the largest value
+    unsigned char reserved;
+    char          low[PREFIX_LENGTH];  // not larger than any value
+    char          high[PREFIX_LENGTH]; // the largest value, or its first PREFIX_LENGTH bytes
+    unsigned char bloom[BLOOM_BYTES];  // the Bloom filter of the values
+
+    /**
+     * add a record to the summary.
+     * @param key[IN] the key of the record
+     * @param value[IN] the value of the record
+     */
+    void add(int key, const ValueView& value);
+
+    /**
+     * @param value[IN] a value
+     * @return false if no record of the page has the value
+     */
+    bool mayContain(const std::string& value) const;
+
+    /**
+     * @param value[IN] a value
+     * @param orEqual[IN] whether a value equal to it counts
+     * @return false if no record of the page has a value less than (or equal to) it
+     */
+    bool mayBeLess(const std::string& value, bool orEqual) const;
+
+    /**
+     * @param value[IN] a value
+     * @param orEqual[IN] whether a value equal to it counts
+     * @return false if no record of the page has a value greater than (or equal to) it
+     */
+    bool mayBeGreater(const std::string& value, bool orEqual) const;
+  };
+
+  static const int ZONES_PER_PAGE = PageFile::PAGE_SIZE / sizeof(Zone);
+
+  ZoneMap();
+
+  /**
+   * open the zone file of a table in read or write mode.
+   * when opened in 'w' mode, if the file does not exist, it is created.
+   * @param filename[IN] the name of the zone file
+   * @param mode[IN] 'r' for read, 'w' for write
+   * @return error code. 0 if no error
+   */
+  RC open(const std::string& filename, char mode);
+
+  /**
+   * close the zone file. in 'w' mode, the zones built since the file was
+   * opened are written out first, for the table ending at end.
+   * @param end[IN] the end record id of the table
+   * @return error code. 0 if no error
+   */
+  RC close(const RecordId& end);
+
+  /**
+   * close the zone file without writing out anything.
+   * @return error code. 0 if no error
+   */
+  RC close();
+
+  /**
+   * @param end[IN] the end record id of a table
+   * @return true if the zones were built for the table as it is now
+   */
+  bool covers(const RecordId& end) const;
+
+  /**
+   * build the zones of a range of pages of a table from its records,
+   * replacing whatever was known about them.
+   * @param tf[IN] the table
+   * @param first[IN] the first page of the range
+   * @param last[IN] the last page of the range
+   * @return error code. 0 if no error
+   */
+  RC summarize(const TableFile& tf, PageId first, PageId last);
+
+  /**
+   * read the zone of a page.
+   * @param pid[IN] the page of the table
+   * @param zone[OUT] its zone
+   * @return error code. RC_INVALID_PID if the page is not summarized
+   */
+  RC getZone(PageId pid, Zone& zone) const;
+
+ private:
+  static const int MAGIC = 0x4d5a4242; // "BBZM"
+  static const int VERSION = 1;
+
+  // the first page of the file
+  struct Header {
+    int      magic;
+    int      version;
+    RecordId end;   // the end record id of the table summarized
+  };
+
+  PageFile pf;    // the zone file; the zone of page pid is in page 1 + pid / ZONES_PER_PAGE
+  RecordId end;   // the end record id of the table summarized
+  std::map<PageId, Zone> changed; // the zones built since the file was opened
+};
+
+#endif // ZONEMAP_H
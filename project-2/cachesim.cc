@@ -0,0 +1,484 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/17/2026
+ */
+
+/*
+ * cachesim: replays page access traces recorded with "bruinbase -t" against
+ * several replacement policies at many cache sizes, and prints the miss
+ * ratio of each (the miss-ratio curves). it also writes synthetic traces.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <list>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <unistd.h>
+#include "Bruinbase.h"
+#include "PageTrace.h"
+
+using std::string;
+using std::vector;
+
+typedef unsigned long long PageKey; // a page of a file: the record without its op
+
+/**
+ * pages in recency order, with the most recently inserted one at the front.
+ */
+class RecencyList {
+ public:
+  bool contains(PageKey key) const { return pos.find(key) != pos.end(); }
+  size_t size() const { return order.size(); }
+
+  void pushFront(PageKey key) {
+    order.push_front(key);
+    pos[key] = order.begin();
+  }
+
+  void remove(PageKey key) {
+    std::unordered_map<PageKey, std::list<PageKey>::iterator>::iterator it = pos.find(key);
+    order.erase(it->second);
+    pos.erase(it);
+  }
+
+  PageKey popBack() {
+    PageKey key = order.back();
+    remove(key);
+    return key;
+  }
+
+ private:
+  std::list<PageKey> order;
+  std::unordered_map<PageKey, std::list<PageKey>::iterator> pos;
+};
+
+/**
+ * a cache of a fixed number of pages run by one replacement policy.
+ */
+class CacheSim {
+ public:
+  CacheSim(size_t capacity) : capacity(capacity) {}
+  virtual ~CacheSim() {}
+
+  /**
+   * @param key[IN] the page accessed
+   * @return true if the cache held the page
+   */
+  virtual bool access(PageKey key) = 0;
+
+ protected:
+  const size_t capacity; // # of pages the cache holds
+};
+
+/**
+ * least recently used, as LRUPolicy of the page cache.
+ */
+class LRUSim : public CacheSim {
+ public:
+  LRUSim(size_t capacity) : CacheSim(capacity) {}
+
+  bool access(PageKey key) {
+    bool hit = pages.contains(key);
+    if (hit) pages.remove(key);
+    else if (pages.size() >= capacity) pages.popBack();
+    pages.pushFront(key);
+    return hit;
+  }
+
+ private:
+  RecencyList pages;
+};
+
+/**
+ * CLOCK (second chance), as ClockPolicy of the page cache: pages are
+ * referenced when they are loaded and whenever they are accessed.
+ */
+class ClockSim : public CacheSim {
+ public:
+  ClockSim(size_t capacity) : CacheSim(capacity), hand(0) {}
+
+  bool access(PageKey key) {
+    std::unordered_map<PageKey, size_t>::iterator it = slotOf.find(key);
+    if (it != slotOf.end()) {
+      slots[it->second].referenced = true;
+      return true;
+    }
+
+    Slot slot = { key, true };
+    if (slots.size() < capacity) {
+      slotOf[key] = slots.size();
+      slots.push_back(slot);
+      return false;
+    }
+
+    // give every referenced page a second chance
+    while (slots[hand].referenced) {
+      slots[hand].referenced = false;
+      hand = (hand + 1) % slots.size();
+    }
+    slotOf.erase(slots[hand].key);
+    slotOf[key] = hand;
+    slots[hand] = slot;
+    hand = (hand + 1) % slots.size();
+    return false;
+  }
+
+ private:
+  struct Slot {
+    PageKey key;
+    bool    referenced;
+  };
+
+  vector<Slot> slots;
+  std::unordered_map<PageKey, size_t> slotOf;
+  size_t hand;
+};
+
+/**
+ * 2Q (Johnson and Shasha): pages seen once wait in a FIFO queue (A1in) and
+ * are only promoted to the LRU list (Am) if they are asked for again after
+ * they left it, while their key is still remembered (A1out). A scan thus
+ * only flushes A1in.
+ */
+class TwoQSim : public CacheSim {
+ public:
+  TwoQSim(size_t capacity) :
+    CacheSim(capacity), kin(std::max<size_t>(1, capacity / 4)), kout(std::max<size_t>(1, capacity / 2)) {}
+
+  bool access(PageKey key) {
+    if (am.contains(key)) {
+      am.remove(key);
+      am.pushFront(key);
+      return true;
+    }
+    if (a1in.contains(key)) return true;
+
+    // make room, preferring the pages seen only once
+    if (am.size() + a1in.size() >= capacity) {
+      if (a1in.size() > kin || am.size() == 0) {
+        a1out.pushFront(a1in.popBack());
+        if (a1out.size() > kout) a1out.popBack();
+      } else {
+        am.popBack();
+      }
+    }
+
+    if (a1out.contains(key)) {
+      a1out.remove(key);
+      am.pushFront(key);
+    } else {
+      a1in.pushFront(key);
+    }
+    return false;
+  }
+
+ private:
+  const size_t kin;  // the share of the cache for A1in
+  const size_t kout; // # of keys remembered in A1out
+  RecencyList a1in, a1out, am;
+};
+
+/**
+ * ARC (Megiddo and Modha): pages seen once (T1) and pages seen at least
+ * twice (T2) share the cache, and the keys recently evicted from either
+ * (B1, B2) move the split between them towards the list that would have
+ * hit.
+ */
+class ARCSim : public CacheSim {
+ public:
+  ARCSim(size_t capacity) : CacheSim(capacity), p(0) {}
+
+  bool access(PageKey key) {
+    if (t1.contains(key) || t2.contains(key)) {
+      if (t1.contains(key)) t1.remove(key);
+      else t2.remove(key);
+      t2.pushFront(key);
+      return true;
+    }
+
+    if (b1.contains(key)) {
+      p = std::min((double)capacity, p + std::max((double)b2.size() / b1.size(), 1.0));
+      replace(false);
+      b1.remove(key);
+      t2.pushFront(key);
+      return false;
+    }
+
+    if (b2.contains(key)) {
+      p = std::max(0.0, p - std::max((double)b1.size() / b2.size(), 1.0));
+      replace(true);
+      b2.remove(key);
+      t2.pushFront(key);
+      return false;
+    }
+
+    size_t total = t1.size() + t2.size() + b1.size() + b2.size();
+    if (t1.size() + b1.size() >= capacity) {
+      if (t1.size() < capacity) {
+        b1.popBack();
+        replace(false);
+      } else {
+        t1.popBack();
+      }
+    } else if (total >= capacity) {
+      if (total >= 2 * capacity) b2.popBack();
+      replace(false);
+    }
+    t1.pushFront(key);
+    return false;
+  }
+
+ private:
+  // evict the least recently used page of T1 or T2, remembering its key
+  void replace(bool inB2) {
+    if (t1.size() > 0 && ((inB2 && t1.size() == (size_t)p) || t1.size() > p)) {
+      b1.pushFront(t1.popBack());
+    } else if (t2.size() > 0) {
+      b2.pushFront(t2.popBack());
+    } else {
+      b1.pushFront(t1.popBack());
+    }
+  }
+
+  double p; // the target size of T1
+  RecencyList t1, t2, b1, b2;
+};
+
+static const char* const POLICIES[] = { "lru", "clock", "2q", "arc" };
+static const int NPOLICIES = sizeof(POLICIES) / sizeof(POLICIES[0]);
+
+static CacheSim* makeSim(int policy, size_t capacity)
+{
+  switch (policy) {
+  case 0: return new LRUSim(capacity);
+  case 1: return new ClockSim(capacity);
+  case 2: return new TwoQSim(capacity);
+  default: return new ARCSim(capacity);
+  }
+}
+
+// the miss ratio of a policy at a cache size
+static double missRatio(int policy, size_t capacity, const vector<PageKey>& keys)
+{
+  CacheSim* sim = makeSim(policy, capacity);
+  long long misses = 0;
+
+  for (size_t i = 0; i < keys.size(); i++) {
+    if (!sim->access(keys[i])) misses++;
+  }
+
+  delete sim;
+  return keys.empty() ? 0 : (double)misses / keys.size();
+}
+
+static int simulate(const string& path, const vector<int>& policies, vector<size_t> sizes, bool readsOnly)
+{
+  RC rc;
+  PageTrace::Header header;
+  vector<PageTrace::Record> records;
+  vector<PageKey> keys;
+  std::unordered_set<PageKey> pages;
+  std::unordered_set<int> files;
+  long long writes = 0;
+
+  if ((rc = PageTrace::load(path, header, records)) < 0) {
+    fprintf(stderr, "Error: cannot read the trace file %s\n", path.c_str());
+    return rc;
+  }
+
+  for (size_t i = 0; i < records.size(); i++) {
+    if (records[i].op() == PageTrace::WRITE) {
+      writes++;
+      if (readsOnly) continue;
+    }
+    keys.push_back((PageKey)records[i].page >> 1);
+    pages.insert(keys.back());
+    files.insert(records[i].fid());
+  }
+
+  fprintf(stdout, "%s: %zu accesses (%lld reads, %lld writes%s) of %zu pages of %d bytes in %zu files\n",
+          path.c_str(), records.size(), (long long)records.size() - writes, writes, readsOnly ? ", ignored" : "",
+          pages.size(), header.pageSize, files.size());
+  if (keys.empty()) return 0;
+  fprintf(stdout, "compulsory miss ratio %.4f\n", (double)pages.size() / keys.size());
+
+  // by default, every power of two up to the cache that holds every page
+  if (sizes.empty()) {
+    for (size_t s = 8; ; s *= 2) {
+      sizes.push_back(s);
+      if (s >= pages.size()) break;
+    }
+  }
+
+  fprintf(stdout, "%12s", "cache pages");
+  for (unsigned j = 0; j < policies.size(); j++) fprintf(stdout, " %8s", POLICIES[policies[j]]);
+  fprintf(stdout, "\n");
+
+  for (unsigned i = 0; i < sizes.size(); i++) {
+    fprintf(stdout, "%12zu", sizes[i]);
+    for (unsigned j = 0; j < policies.size(); j++) {
+      fprintf(stdout, " %8.4f", missRatio(policies[j], sizes[i], keys));
+    }
+    fprintf(stdout, "\n");
+  }
+  fprintf(stdout, "\n");
+
+  return 0;
+}
+
+// write a synthetic trace of the given kind
+static int generate(const string& kind, long long n, long long k, const string& path)
+{
+  std::mt19937_64 rng(1);
+  vector<PageTrace::Record> records;
+  vector<double> cdf;
+
+  // a zipf distribution (exponent 1) over k pages, for the hot pages
+  double sum = 0;
+  for (long long i = 1; i <= k; i++) {
+    sum += 1.0 / i;
+    cdf.push_back(sum);
+  }
+  std::uniform_real_distribution<double> uniform(0, sum);
+
+  for (long long i = 0; i < n; i++) {
+    long long time = i * 1000;
+    PageId pid;
+
+    if (kind == "zipf") {
+      pid = std::lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin();
+      records.push_back(PageTrace::Record::make(time, 1, pid, PageTrace::READ));
+    } else if (kind == "loop") {
+      // the same pages read in order, again and again
+      records.push_back(PageTrace::Record::make(time, 1, i % k, PageTrace::READ));
+    } else if (kind == "mixed") {
+      // zipf lookups, with a scan of a k-page table every 8k accesses
+      if (i % (8 * k) < k) {
+        records.push_back(PageTrace::Record::make(time, 2, i % (8 * k), PageTrace::READ));
+      } else {
+        pid = std::lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin();
+        records.push_back(PageTrace::Record::make(time, 1, pid, PageTrace::READ));
+      }
+    } else {
+      fprintf(stderr, "Error: unknown kind of trace %s\n", kind.c_str());
+      return RC_INVALID_ATTRIBUTE;
+    }
+  }
+
+  if (PageTrace::save(path, 1024, records) < 0) {
+    fprintf(stderr, "Error: cannot write the trace file %s\n", path.c_str());
+    return RC_FILE_WRITE_FAILED;
+  }
+  return 0;
+}
+
+static void usage(const char* prog)
+{
+  fprintf(stderr, "usage: %s [-p policy,...] [-s pages,...] [-r] tracefile...\n", prog);
+  fprintf(stderr, "       %s -g zipf|loop|mixed [-n accesses] [-k pages] tracefile\n", prog);
+  fprintf(stderr, "  -p  the policies to simulate: lru, clock, 2q, arc (default all)\n");
+  fprintf(stderr, "  -s  the cache sizes in pages (default powers of two up to every page)\n");
+  fprintf(stderr, "  -r  ignore page writes\n");
+  fprintf(stderr, "  -g  write a synthetic trace instead: zipf lookups, a loop of scans, or\n");
+  fprintf(stderr, "      zipf lookups mixed with scans of another file\n");
+  fprintf(stderr, "  -n  # of accesses of the synthetic trace (default 1000000)\n");
+  fprintf(stderr, "  -k  # of pages of the synthetic trace (default 10000)\n");
+}
+
+// split a comma separated list
+static vector<string> split(const char* s)
+{
+  vector<string> items;
+  string item;
+
+  for (; ; s++) {
+    if (*s == ',' || *s == 0) {
+      if (!item.empty()) items.push_back(item);
+      item.clear();
+      if (*s == 0) break;
+    } else {
+      item += *s;
+    }
+  }
+  return items;
+}
+
+int main(int argc, char* argv[])
+{
+  int opt;
+  vector<int> policies;
+  vector<size_t> sizes;
+  bool readsOnly = false;
+  const char* kind = NULL;
+  long long n = 1000000, k = 10000;
+
+  while ((opt = getopt(argc, argv, "p:s:rg:n:k:")) != -1) {
+    switch (opt) {
+    case 'p': {
+      vector<string> names = split(optarg);
+      for (unsigned i = 0; i < names.size(); i++) {
+        int p;
+        for (p = 0; p < NPOLICIES && names[i] != POLICIES[p]; p++) { }
+        if (p == NPOLICIES) {
+          fprintf(stderr, "Error: unknown policy %s\n", names[i].c_str());
+          return 1;
+        }
+        policies.push_back(p);
+      }
+      break;
+    }
+    case 's': {
+      vector<string> items = split(optarg);
+      for (unsigned i = 0; i < items.size(); i++) {
+        long long s = atoll(items[i].c_str());
+        if (s <= 0) {
+          fprintf(stderr, "Error: invalid cache size %s\n", items[i].c_str());
+          return 1;
+        }
+        sizes.push_back((size_t)s);
+      }
+      break;
+    }
+    case 'r':
+      readsOnly = true;
+      break;
+    case 'g':
+      kind = optarg;
+      break;
+    case 'n':
+      n = atoll(optarg);
+      break;
+    case 'k':
+      k = atoll(optarg);
+      break;
+    default:
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (optind >= argc || (kind != NULL && optind != argc - 1) || n <= 0 || k <= 0) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  if (kind != NULL) return generate(kind, n, k, argv[optind]) < 0 ? 1 : 0;
+
+  if (policies.empty()) {
+    for (int p = 0; p < NPOLICIES; p++) policies.push_back(p);
+  }
+  for (int i = optind; i < argc; i++) {
+    if (simulate(argv[i], policies, sizes, readsOnly) < 0) return 1;
+  }
+
+  return 0;
+}
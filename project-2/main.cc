@@ -7,13 +7,137 @@
  * @date 3/24/2008
  */
  
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
 #include "Bruinbase.h"
 #include "SqlEngine.h"
+#include "PageFile.h"
+#include "WriteAheadLog.h"
+#include "PageTrace.h"
 
-int main()
+static void usage(const char* prog)
 {
+  fprintf(stderr, "usage: %s [-c cachesize[K|M|G]] [-p lru|clock] [-m] [-w] [-d] [-z] [-l] [-P] [-t tracefile] [-C]\n", prog);
+  fprintf(stderr, "  -c  size of the page cache (default 4M)\n");
+  fprintf(stderr, "  -p  replacement policy of the page cache (default lru)\n");
+  fprintf(stderr, "  -m  access table and index files through mmap\n");
+  fprintf(stderr, "  -w  write pages back from the page cache instead of through it\n");
+  fprintf(stderr, "  -d  bypass the OS page cache (O_DIRECT)\n");
+  fprintf(stderr, "  -z  store the pages of new table and index files compressed\n");
+  fprintf(stderr, "  -l  log page writes to bruinbase.wal, so that loaded rows survive a crash\n");
+  fprintf(stderr, "  -P  read the pages cached by the last run back at startup and record them at exit\n");
+  fprintf(stderr, "  -t  record every page access to tracefile (see cachesim)\n");
+  fprintf(stderr, "  -C  run every SELECT from an empty page cache (cold cache timing)\n");
+}
+
+// parse a size such as "64M" into bytes. returns 0 on malformed input
+static size_t parseSize(const char* s)
+{
+  char*  end;
+  size_t size = strtoull(s, &end, 10);
+
+  switch (*end) {
+  case 'k': case 'K': size <<= 10; end++; break;
+  case 'm': case 'M': size <<= 20; end++; break;
+  case 'g': case 'G': size <<= 30; end++; break;
+  }
+
+  return (*end == 0) ? size : 0;
+}
+
+int main(int argc, char* argv[])
+{
+  int opt;
+  int flags = 0;
+  bool logged = false;
+  bool persistCache = false;
+  const char* trace = NULL;
+
+  // configure the page cache from the command line
+  while ((opt = getopt(argc, argv, "c:p:mwdzlPt:C")) != -1) {
+    switch (opt) {
+    case 'c':
+      if (PageFile::setCacheSize(parseSize(optarg)) < 0) {
+        fprintf(stderr, "Error: invalid cache size %s\n", optarg);
+        return 1;
+      }
+      break;
+    case 'p':
+      if (PageFile::setCachePolicy(optarg) < 0) {
+        fprintf(stderr, "Error: unknown cache policy %s\n", optarg);
+        return 1;
+      }
+      break;
+    case 'm':
+      flags |= PageFile::MMAP;
+      break;
+    case 'w':
+      flags |= PageFile::WRITE_BACK;
+      break;
+    case 'd':
+      flags |= PageFile::DIRECT;
+      break;
+    case 'z':
+      flags |= PageFile::COMPRESS;
+      break;
+    case 'l':
+      logged = true;
+      break;
+    case 'P':
+      persistCache = true;
+      break;
+    case 't':
+      trace = optarg;
+      break;
+    case 'C':
+      SqlEngine::setColdCache(true);
+      break;
+    default:
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  PageFile::setDefaultFlags(flags);
+
+  if (logged && WriteAheadLog::open() < 0) {
+    fprintf(stderr, "Error: cannot open the write-ahead log %s\n", WriteAheadLog::LOG_FILE);
+    return 1;
+  }
+
+  if (trace != NULL && PageTrace::open(trace, PageFile::PAGE_SIZE) < 0) {
+    fprintf(stderr, "Error: cannot create the trace file %s\n", trace);
+    if (logged) WriteAheadLog::close();
+    return 1;
+  }
+
+  // start with the pages the last run ended with; the first run has none
+  if (persistCache) {
+    RC rc = PageFile::loadCache(PageFile::CACHE_FILE);
+    if (rc < 0 && rc != RC_FILE_OPEN_FAILED) {
+      fprintf(stderr, "Warning: cannot read the page cache from %s\n", PageFile::CACHE_FILE);
+    }
+  }
+
   // run the SQL engine taking user commands from standard input (console).
   SqlEngine::run(stdin);
 
-  return 0;
+  // whatever fails on the way out, the log is still checkpointed
+  int status = 0;
+
+  if (trace != NULL && PageTrace::close() < 0) {
+    fprintf(stderr, "Error: cannot write the trace file %s\n", trace);
+    status = 1;
+  }
+
+  if (persistCache && SqlEngine::saveCache() < 0) status = 1;
+
+  // the pages logged are on disk now; the log is not needed anymore
+  if (logged && WriteAheadLog::close() < 0) {
+    fprintf(stderr, "Error: cannot checkpoint the write-ahead log\n");
+    status = 1;
+  }
+
+  return status;
 }
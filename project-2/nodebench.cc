@@ -0,0 +1,118 @@
+/*
+ * Redistribution of this file is permitted under the terms of the GNU
+ * Public License (GPL).
+ *
+ * @date 10/17/2026
+ */
+
+/*
+ * nodebench: times the search of the keys of a full B+tree node with each
+ * way of searching them (see KeySearch.h), at the page size it is built
+ * with (make nodebenches): the lowerBound() of a leaf, as in
+ * BTLeafNode::locate(), and the upperBound() of a non-leaf, as in
+ * BTNonLeafNode::locateChildPtr().
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "BTreeNode.h"
+
+using std::vector;
+
+/**
+ * fill a node with the keys 0, 2, 4, ... until it is full.
+ * @return the # of keys of the node
+ */
+template <typename Node, typename Value>
+static unsigned fill(Node& node, bool leaf)
+{
+  node.clearAll();
+  if (leaf) node.setLeaf();
+  else node.setNonLeaf();
+
+  for (int key = 0; node.insertPair(key, Value()) == 0; key += 2)
+    ;
+  return node.getKeyCount();
+}
+
+/**
+ * search the keys of a full node for every probe.
+ * @param probes[IN] the keys to search for
+ * @param upper[IN] true for upperBound(), false for lowerBound()
+ * @param leaf[IN] true for a leaf, false for a non-leaf
+ * @param sum[OUT] the sum of the indexes found, to check the searches against each other
+ * @return the nanoseconds per search
+ */
+template <typename Value, typename Search>
+static double timeSearch(const vector<int>& probes, bool upper, bool leaf, unsigned long long& sum)
+{
+  typedef BTRawNode<int, Value, INVALID_KEY, Search> Node;
+  Node* node = new Node();
+
+  fill<Node, Value>(*node, leaf);
+
+  sum = 0;
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+  for (unsigned i = 0; i < probes.size(); i++) {
+    sum += upper ? node->upperBound(probes[i]) : node->lowerBound(probes[i]);
+  }
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+  delete node;
+  return std::chrono::duration<double, std::nano>(end - begin).count() / probes.size();
+}
+
+template <typename Search>
+static bool report(const char* name, const vector<int>& probes, const unsigned long long expected[2])
+{
+  unsigned long long leafSum, nonLeafSum;
+  double leafNs    = timeSearch<LeafRecordId, Search>(probes, false, true, leafSum);
+  double nonLeafNs = timeSearch<PageId, Search>(probes, true, false, nonLeafSum);
+  bool   same = (leafSum == expected[0] && nonLeafSum == expected[1]);
+
+  fprintf(stdout, "%-14s %12.1f %12.1f%s\n", name, leafNs, nonLeafNs, same ? "" : "  WRONG RESULTS");
+  return same;
+}
+
+int main(int argc, char* argv[])
+{
+  const int     searches = (argc > 1) ? atoi(argv[1]) : 2000000;
+  vector<int>   probes(searches);
+  std::mt19937  random(1);
+  unsigned long long expected[2];
+  bool          ok = true;
+
+  BTRawLeaf*    leaf = new BTRawLeaf();
+  BTRawNonLeaf* nonLeaf = new BTRawNonLeaf();
+  unsigned      leafKeys = fill<BTRawLeaf, LeafRecordId>(*leaf, true);
+  unsigned      nonLeafKeys = fill<BTRawNonLeaf, PageId>(*nonLeaf, false);
+  delete leaf;
+  delete nonLeaf;
+
+  // half the probes are keys of the node, the others fall between them,
+  // and a few before the first or after the last
+  std::uniform_int_distribution<int> pick(-2, 2 * (int)MAX(leafKeys, nonLeafKeys) + 1);
+  for (int i = 0; i < searches; i++) {
+    probes[i] = pick(random);
+  }
+
+  fprintf(stdout, "page size %d: %u keys per leaf, %u per non-leaf\n", PageFile::PAGE_SIZE, leafKeys, nonLeafKeys);
+  fprintf(stdout, "%-14s %12s %12s\n", "ns per search", "leaf", "non-leaf");
+
+  timeSearch<LeafRecordId, LinearKeySearch>(probes, false, true, expected[0]);
+  timeSearch<PageId, LinearKeySearch>(probes, true, false, expected[1]);
+
+  ok &= report<LinearKeySearch>("linear", probes, expected);
+  ok &= report<BinaryKeySearch>("binary", probes, expected);
+#if defined(__AVX2__)
+  ok &= report<SimdKeySearch>("simd (avx2)", probes, expected);
+#elif defined(__SSE2__)
+  ok &= report<SimdKeySearch>("simd (sse2)", probes, expected);
+#endif
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,30 @@
+#!/bin/sh
+#
+# compare the page cache path (lseek + read) with the mmap path (-m).
+# usage: sh bench_mmap.sh [rows] [cachesize]
+#
+
+ROWS=${1:-200000}
+CACHE=${2:-64K}
+
+rm -f bench.tbl bench.idx bench.zone bench.del
+
+# synthetic table: increasing keys, short values
+awk -v n=$ROWS 'BEGIN { srand(1); for (i = 0; i < n; i++) printf "%d,\"Movie title %d\"\n", 3*i, int(rand()*1000000) }' > bench.del
+echo "LOAD bench FROM 'bench.del' WITH INDEX" | ../bruinbase > /dev/null
+
+cat > bench.sql <<SQL
+SELECT COUNT(*) FROM bench WHERE value <> 'x'
+SELECT COUNT(*) FROM bench WHERE value > 'Movie title 5'
+SELECT COUNT(*) FROM bench WHERE key > $ROWS AND value <> 'x'
+SELECT * FROM bench WHERE key = 300
+SELECT * FROM bench WHERE key = $ROWS
+SQL
+
+for opts in "-c $CACHE" "-c $CACHE -m"; do
+  ../bruinbase $opts < bench.sql 2>&1 >/dev/null | \
+    awk -v opts="$opts" '/seconds to run/ { t += $2; p += $(NF-1) }
+                         END { printf "%-16s %8.3f seconds %10d pages read\n", opts, t, p }'
+done
+
+rm -f bench.tbl bench.idx bench.zone bench.del bench.sql
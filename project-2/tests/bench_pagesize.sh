@@ -0,0 +1,42 @@
+#!/bin/sh
+#
+# compare the page sizes: B+tree height, pages read and time of the same
+# queries, on xlarge.del and on a larger synthetic table.
+# the builds are made with "make pagesizes" in the parent directory.
+# usage: sh bench_pagesize.sh [rows]
+#
+
+ROWS=${1:-500000}
+
+(cd .. && make bruinbase pagesizes > /dev/null) || exit 1
+
+rm -f bench.del
+awk -v n=$ROWS 'BEGIN { srand(1); for (i = 0; i < n; i++) printf "%d,\"Movie title %d\"\n", 3*i, int(rand()*1000000) }' > bench.del
+
+# the seconds and pages reported by the bruinbase statements on stdin
+stats() {
+  ../$1 2>&1 >/dev/null | awk '/seconds to run/ { t += $2; p += $(NF-1) } END { printf "%8.3f %8d", t, p }'
+}
+
+printf "%-16s %-10s %6s %17s %17s %17s\n" "" "" "" "load" "count(*) scan" "range via index"
+printf "%-16s %-10s %6s %17s %17s %17s\n" "binary" "data" "height" "sec   pages" "sec   pages" "sec   pages"
+
+for bin in bruinbase bruinbase-4k bruinbase-8k bruinbase-16k bruinbase-64k; do
+  for data in xlarge bench; do
+    rm -f $data.tbl $data.idx $data.zone
+    mid=$((`tail -1 $data.del | cut -d, -f1` / 2))
+
+    load=`echo "LOAD $data FROM '$data.del' WITH INDEX" | stats $bin`
+
+    # as reported by the index itself
+    height=`echo "PREWARM $data" | ../$bin 2>&1 >/dev/null | sed -n 's/.* is \([0-9]*\) levels high.*/\1/p'`
+
+    scan=`echo "SELECT COUNT(*) FROM $data WHERE value <> 'x'" | stats $bin`
+    range=`echo "SELECT * FROM $data WHERE key > $mid AND key < $((mid + 3000))" | stats $bin`
+
+    printf "%-16s %-10s %6d %17s %17s %17s\n" $bin $data $height "$load" "$scan" "$range"
+    rm -f $data.tbl $data.idx $data.zone
+  done
+done
+
+rm -f bench.del
@@ -0,0 +1,50 @@
+#!/bin/sh
+#
+# load every test table by rows and by columns, with and without an index,
+# check that the same queries return the same tuples, and print the pages
+# each layout reads from a cold cache.
+# usage: sh columns.sh
+#
+
+(cd .. && make bruinbase > /dev/null) || exit 1
+
+queries() {
+  cat <<EOF
+SELECT COUNT(*) FROM $1
+SELECT key FROM $1 WHERE key > 4000
+SELECT * FROM $1 WHERE key > 100 AND key < 900
+SELECT value FROM $1 WHERE key = 489
+SELECT * FROM $1 WHERE value > 'T'
+SELECT * FROM $1 WHERE key < 3000 AND value < 'M'
+SELECT * FROM $1
+EOF
+}
+
+# run the queries on every table loaded with the given options
+run() {
+  rm -f *.tbl *.idx *.key *.code *.dict *.map *.fsm *.zone
+  for data in xsmall small medium large xlarge; do
+    echo "LOAD $data FROM '$data.del' $1"
+    queries $data
+  done | ../bruinbase -C 2> $2.err > $2.out
+}
+
+run "WITH INDEX" rows-index
+run "WITH INDEX, COLUMNS" columns-index
+run "" rows
+run "WITH COLUMNS" columns
+
+status=0
+cmp -s rows-index.out columns-index.out || { echo "FAIL: WITH INDEX, COLUMNS"; status=1; }
+cmp -s rows.out columns.out || { echo "FAIL: WITH COLUMNS"; status=1; }
+[ $status -eq 0 ] && echo "same results by rows and by columns"
+
+# the pages read by the queries on xlarge, the last table loaded
+printf "%-14s" "query"; queries xlarge | awk '{ printf " %6s", "#" NR }'; echo
+for layout in rows rows-index columns columns-index; do
+  printf "%-14s" $layout
+  grep "select command" $layout.err | tail -7 | awk '{ printf " %6d", $(NF-3) }'; echo
+done
+
+rm -f *.out *.err *.tbl *.idx *.key *.code *.dict *.map *.fsm *.zone
+exit $status
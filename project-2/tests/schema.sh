@@ -0,0 +1,57 @@
+#!/bin/sh
+#
+# create the movie table of project 1B with typed columns, load it with
+# and without an index, and check the answers of queries on its columns.
+# usage: sh schema.sh
+#
+
+(cd .. && make bruinbase > /dev/null) || exit 1
+
+DATA=../../project-1b/data/movie.del
+
+# the queries, each with the answer the loaded table must give
+queries() {
+  cat <<EOF
+SELECT COUNT(*) FROM movie|3616
+SELECT COUNT(*) FROM movie WHERE year > 2000|749
+SELECT COUNT(*) FROM movie WHERE year >= 1990 AND rating = 'R'|2415
+SELECT COUNT(*) FROM movie WHERE company = 'Warner Bros.'|9
+SELECT COUNT(*) FROM movie WHERE id >= 4700 AND rating = 'R'|12
+SELECT COUNT(*) FROM movie WHERE id < 1000 AND year < 1950|1
+SELECT title FROM movie WHERE year = 1934 AND rating = 'PG'|Baby Take a Bow
+SELECT year FROM movie WHERE id = 2342|1944
+SELECT * FROM movie WHERE id = 272|272 'Baby Take a Bow' 1934 'PG' 'Fox Film Corporation'
+EOF
+}
+
+# run the queries on the table loaded with the given options
+run() {
+  rm -f movie.*
+  {
+    echo "CREATE TABLE movie (id INT, title VARCHAR(100), year INT, rating VARCHAR(10), company VARCHAR(50))"
+    echo "LOAD movie FROM '$DATA' $1"
+    queries | cut -d'|' -f1
+  } | ../bruinbase 2> /dev/null | sed 's/Bruinbase> //g' | grep -v '^$' > $2.out
+}
+
+status=0
+queries | cut -d'|' -f2 > schema.expected
+for options in "" "WITH INDEX"; do
+  run "$options" schema
+  cmp -s schema.expected schema.out || { echo "FAIL: LOAD $options"; diff schema.expected schema.out; status=1; }
+done
+[ $status -eq 0 ] && echo "typed columns compared right"
+
+# the keywords of SHOW STATS, PREWARM, SAVE CACHE and CREATE TABLE still
+# name tables and columns
+rm -f stats.*
+printf '1,"one"\n2,"two"\n' > keywords.del
+answer=`{
+  echo "CREATE TABLE stats (show INT, cache VARCHAR(10))"
+  echo "LOAD stats FROM 'keywords.del' WITH INDEX"
+  echo "SELECT cache FROM stats WHERE show = 2"
+} | ../bruinbase 2> /dev/null | sed 's/Bruinbase> //g' | grep -v '^$'`
+[ "$answer" = "two" ] || { echo "FAIL: keywords as names: $answer"; status=1; }
+
+rm -f schema.expected schema.out movie.* stats.* keywords.del
+exit $status
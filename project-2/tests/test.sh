@@ -1,10 +1,10 @@
 #!/bin/sh
 
-rm -f xsmall.tbl xsmall.idx
-rm -f small.tbl small.idx
-rm -f medium.tbl medium.idx
-rm -f large.tbl large.idx
-rm -f xlarge.tbl xlarge.idx
+rm -f xsmall.tbl xsmall.idx xsmall.zone
+rm -f small.tbl small.idx small.zone
+rm -f medium.tbl medium.idx medium.zone
+rm -f large.tbl large.idx large.zone
+rm -f xlarge.tbl xlarge.idx xlarge.zone
 
 ../bruinbase < test.sql
 
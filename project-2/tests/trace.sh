@@ -0,0 +1,21 @@
+#!/bin/sh
+#
+# record the page accesses of test.sql and of three synthetic workloads,
+# and print the miss-ratio curves of every cache policy for each of them.
+# the traces are left in this directory (*.trace).
+# usage: sh trace.sh
+#
+
+(cd .. && make bruinbase cachesim > /dev/null) || exit 1
+
+rm -f xsmall.tbl xsmall.idx xsmall.zone small.tbl small.idx small.zone medium.tbl medium.idx medium.zone
+rm -f large.tbl large.idx large.zone xlarge.tbl xlarge.idx xlarge.zone
+
+../bruinbase -t test.trace < test.sql > /dev/null 2>&1 || exit 1
+
+# hot pages only, a loop of scans larger than most caches, and both mixed
+../cachesim -g zipf -n 1000000 -k 10000 zipf.trace || exit 1
+../cachesim -g loop -n 1000000 -k 5000 loop.trace || exit 1
+../cachesim -g mixed -n 1000000 -k 2000 mixed.trace || exit 1
+
+../cachesim test.trace zipf.trace loop.trace mixed.trace